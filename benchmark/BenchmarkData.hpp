@@ -0,0 +1,89 @@
+/**
+ * Inputs shared by the microbenchmarks: a text file given on the command line
+ * and synthetic byte distributions, plus the counters every benchmark reports.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef BENCHMARKDATA_HPP
+#define BENCHMARKDATA_HPP
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Class for BenchmarkData that builds the inputs the benchmarks run over.
+ */
+class BenchmarkData {
+  private:
+    static const size_t SYNTHETIC_SIZE = 1 << 20;  // bytes of synthetic inputs
+    static const unsigned int SEED = 100;  // same inputs on every run
+
+  public:
+    /* One input to run benchmarks over */
+    struct Dataset {
+        string name;        // shown after the benchmark's name
+        vector<byte> data;  // bytes of the input
+    };
+
+    /* Builds the inputs: the text file if it can be read, then uniformly
+     * random bytes, bytes where each value is half as likely as the one
+     * before, and a single repeated byte.
+     * @param fileName Text file to read, skipped if it cannot be opened
+     * @return inputs to run benchmarks over
+     */
+    static vector<Dataset> load(const string& fileName) {
+        vector<Dataset> datasets;
+
+        ifstream in(fileName, ios::binary);
+        if (in.is_open()) {
+            string name = fileName.substr(fileName.find_last_of('/') + 1);
+            datasets.push_back(
+                Dataset{name, vector<byte>(istreambuf_iterator<char>(in),
+                                           istreambuf_iterator<char>())});
+        }
+
+        mt19937 random(SEED);
+        Dataset uniform{"uniform", vector<byte>(SYNTHETIC_SIZE)};
+        uniform_int_distribution<unsigned int> anyByte(0, UINT8_MAX);
+        for (byte& b : uniform.data) {
+            b = anyByte(random);
+        }
+        datasets.push_back(uniform);
+
+        Dataset skewed{"skewed", vector<byte>(SYNTHETIC_SIZE)};
+        geometric_distribution<unsigned int> halving(0.5);
+        for (byte& b : skewed.data) {
+            unsigned int value = halving(random);
+            b = (value > UINT8_MAX) ? UINT8_MAX : value;
+        }
+        datasets.push_back(skewed);
+
+        datasets.push_back(
+            Dataset{"single", vector<byte>(SYNTHETIC_SIZE, 'a')});
+        return datasets;
+    }
+
+    /* Reports the throughput of a benchmark that handles the given number of
+     * symbols each iteration, as bytes per second and time per symbol.
+     * @param state State of the running benchmark
+     * @param symbols Symbols handled each iteration, one byte each
+     */
+    static void setSymbolCounters(benchmark::State& state, size_t symbols) {
+        state.SetBytesProcessed((int64_t)state.iterations() * symbols);
+        // inverted rate, shown in seconds with a prefix such as 5.3ns
+        state.counters["time_per_symbol"] = benchmark::Counter(
+            symbols, benchmark::Counter::kIsIterationInvariantRate |
+                         benchmark::Counter::kInvert);
+    }
+};
+
+#endif  // BENCHMARKDATA_HPP
@@ -0,0 +1,39 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "BenchmarkData.hpp"
+#include "BitInputStream.hpp"
+
+using namespace std;
+
+#define BIT_IN_BYTE 8
+#define DEFAULT_INPUT "data/warandpeace.txt"
+
+/* Reads every bit of the input one at a time, reading it from memory */
+static void BM_ReadBit(benchmark::State& state,
+                       const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    for (auto _ : state) {
+        BitInputStream is(data.data(), data.size());
+        unsigned int ones = 0;
+        for (size_t i = 0; i < data.size() * BIT_IN_BYTE; i++) {
+            ones += is.readBit();
+        }
+        benchmark::DoNotOptimize(ones);
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    static vector<BenchmarkData::Dataset> datasets =
+        BenchmarkData::load(argc > 1 ? argv[1] : DEFAULT_INPUT);
+    for (const BenchmarkData::Dataset& dataset : datasets) {
+        benchmark::RegisterBenchmark(("BM_ReadBit/" + dataset.name).c_str(),
+                                     BM_ReadBit, &dataset);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
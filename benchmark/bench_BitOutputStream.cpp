@@ -0,0 +1,44 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "BenchmarkData.hpp"
+#include "BitOutputStream.hpp"
+
+using namespace std;
+
+#define BIT_IN_BYTE 8
+#define DEFAULT_INPUT "data/warandpeace.txt"
+
+/* Writes every bit of the input one at a time, most significant bit first */
+static void BM_WriteBit(benchmark::State& state,
+                        const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<byte> out;
+    out.reserve(data.size());
+    for (auto _ : state) {
+        out.clear();
+        BitOutputStream os(out);
+        for (byte symbol : data) {
+            for (int bit = BIT_IN_BYTE - 1; bit >= 0; bit--) {
+                os.writeBit((symbol >> bit) & 1);
+            }
+        }
+        os.flush();
+        benchmark::DoNotOptimize(out.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    static vector<BenchmarkData::Dataset> datasets =
+        BenchmarkData::load(argc > 1 ? argv[1] : DEFAULT_INPUT);
+    for (const BenchmarkData::Dataset& dataset : datasets) {
+        benchmark::RegisterBenchmark(("BM_WriteBit/" + dataset.name).c_str(),
+                                     BM_WriteBit, &dataset);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
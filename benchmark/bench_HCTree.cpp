@@ -0,0 +1,124 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "BenchmarkData.hpp"
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "HCTree.hpp"
+#include "Histogram.hpp"
+
+using namespace std;
+
+#define ASCII_MAX 256
+#define DEFAULT_INPUT "data/warandpeace.txt"
+
+/* Builds the tree, its code table and its decoding table from the input's
+ * frequencies, one tree per iteration */
+static void BM_Build(benchmark::State& state,
+                     const BenchmarkData::Dataset* dataset) {
+    vector<uint64_t> freqs(ASCII_MAX);
+    Histogram::count(dataset->data.data(), dataset->data.size(), freqs);
+    HCTree tree;
+    for (auto _ : state) {
+        tree.build(freqs);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/* Encodes every symbol of the input into memory */
+static void BM_Encode(benchmark::State& state,
+                      const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<uint64_t> freqs(ASCII_MAX);
+    Histogram::count(data.data(), data.size(), freqs);
+    HCTree tree;
+    tree.build(freqs);
+
+    vector<byte> out;
+    out.reserve(data.size());
+    for (auto _ : state) {
+        out.clear();
+        BitOutputStream os(out);
+        for (byte symbol : data) {
+            tree.encode(symbol, os);
+        }
+        os.flush();
+        benchmark::DoNotOptimize(out.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+/* Decodes every symbol of the encoded input from memory */
+static void BM_Decode(benchmark::State& state,
+                      const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<uint64_t> freqs(ASCII_MAX);
+    Histogram::count(data.data(), data.size(), freqs);
+    HCTree tree;
+    tree.build(freqs);
+
+    vector<byte> encoded;
+    BitOutputStream os(encoded);
+    for (byte symbol : data) {
+        tree.encode(symbol, os);
+    }
+    os.flush();
+
+    vector<byte> out(data.size());
+    for (auto _ : state) {
+        BitInputStream is(encoded.data(), encoded.size());
+        for (byte& symbol : out) {
+            symbol = tree.decode(is);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+/* Decodes every symbol of the encoded input from memory, several symbols per
+ * lookup of the multi-symbol table */
+static void BM_DecodeMany(benchmark::State& state,
+                          const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<uint64_t> freqs(ASCII_MAX);
+    Histogram::count(data.data(), data.size(), freqs);
+    HCTree tree;
+    tree.build(freqs);
+    tree.buildMultiDecodeTable();
+
+    vector<byte> encoded;
+    BitOutputStream os(encoded);
+    for (byte symbol : data) {
+        tree.encode(symbol, os);
+    }
+    os.flush();
+
+    vector<byte> out(data.size());
+    for (auto _ : state) {
+        BitInputStream is(encoded.data(), encoded.size());
+        tree.decodeMany(is, out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    static vector<BenchmarkData::Dataset> datasets =
+        BenchmarkData::load(argc > 1 ? argv[1] : DEFAULT_INPUT);
+    for (const BenchmarkData::Dataset& dataset : datasets) {
+        benchmark::RegisterBenchmark(("BM_Build/" + dataset.name).c_str(),
+                                     BM_Build, &dataset);
+        benchmark::RegisterBenchmark(("BM_Encode/" + dataset.name).c_str(),
+                                     BM_Encode, &dataset);
+        benchmark::RegisterBenchmark(("BM_Decode/" + dataset.name).c_str(),
+                                     BM_Decode, &dataset);
+        benchmark::RegisterBenchmark(("BM_DecodeMany/" + dataset.name).c_str(),
+                                     BM_DecodeMany, &dataset);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
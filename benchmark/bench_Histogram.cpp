@@ -0,0 +1,71 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "BenchmarkData.hpp"
+#include "Histogram.hpp"
+
+using namespace std;
+
+#define ASCII_MAX 256
+#define DEFAULT_INPUT "data/warandpeace.txt"
+#define ZEROS_SIZE (1 << 20)  // bytes of the zero-heavy input
+#define ZEROS_ODDS 16         // one byte in this many is not a zero
+#define ZEROS_SEED 100        // same input on every run
+
+/* Counts every byte of the input one at a time into a single table */
+static void BM_CountSimple(benchmark::State& state,
+                           const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<uint64_t> freqs(ASCII_MAX);
+    for (auto _ : state) {
+        Histogram::countSimple(data.data(), data.size(), freqs);
+        benchmark::DoNotOptimize(freqs.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+/* Counts every byte of the input a word at a time into interleaved tables */
+static void BM_CountInterleaved(benchmark::State& state,
+                                const BenchmarkData::Dataset* dataset) {
+    const vector<byte>& data = dataset->data;
+    vector<uint64_t> freqs(ASCII_MAX);
+    for (auto _ : state) {
+        Histogram::countInterleaved(data.data(), data.size(), freqs);
+        benchmark::DoNotOptimize(freqs.data());
+    }
+    BenchmarkData::setSymbolCounters(state, data.size());
+}
+
+/* Builds an input that is almost all zeros, where a single table makes every
+ * byte wait on the same counter.
+ * @return input with a random nonzero byte about once every ZEROS_ODDS bytes
+ */
+static BenchmarkData::Dataset zeroHeavy() {
+    mt19937 random(ZEROS_SEED);
+    uniform_int_distribution<unsigned int> odds(0, ZEROS_ODDS - 1);
+    uniform_int_distribution<unsigned int> nonzero(1, UINT8_MAX);
+    BenchmarkData::Dataset zeros{"zeros", vector<byte>(ZEROS_SIZE)};
+    for (byte& b : zeros.data) {
+        b = (odds(random) == 0) ? nonzero(random) : 0;
+    }
+    return zeros;
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    static vector<BenchmarkData::Dataset> datasets =
+        BenchmarkData::load(argc > 1 ? argv[1] : DEFAULT_INPUT);
+    datasets.push_back(zeroHeavy());
+    for (const BenchmarkData::Dataset& dataset : datasets) {
+        benchmark::RegisterBenchmark(("BM_CountSimple/" + dataset.name).c_str(),
+                                     BM_CountSimple, &dataset);
+        benchmark::RegisterBenchmark(
+            ("BM_CountInterleaved/" + dataset.name).c_str(),
+            BM_CountInterleaved, &dataset);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -5,14 +5,21 @@ using namespace std;
 
 class FileUtils {
   public:
+    /* Check if a given file name stands for stdin or stdout */
+    static bool isStdStream(const string& fileName) { return fileName == "-"; }
+
     /* Check if a given data file is valid */
     static bool isValidFile(string fileName) {
+        if (isStdStream(fileName)) {  // stdin can always be read
+            return true;
+        }
+
         ifstream in;
         in.open(fileName, ios::binary);
 
         // Check if input file was actually opened
         if (!in.is_open()) {
-            cout << "Invalid input file. No file was opened. Please try "
+            cerr << "Invalid input file. No file was opened. Please try "
                     "again.\n";
             return false;
         }
@@ -23,6 +30,10 @@ class FileUtils {
 
     /* Check if given file is empty */
     static bool isEmptyFile(string fileName) {
+        if (isStdStream(fileName)) {  // peek leaves the byte to be read later
+            return cin.peek() == EOF;
+        }
+
         ifstream inFile;
         // if the given file is empty, output empty file
         inFile.open(fileName, ios::binary);
@@ -34,4 +45,22 @@ class FileUtils {
         inFile.close();
         return false;
     }
+
+    /* Opens a given input file, or gives stdin for "-" */
+    static istream& openInput(string fileName, ifstream& file) {
+        if (isStdStream(fileName)) {
+            return cin;
+        }
+        file.open(fileName, ios::binary);
+        return file;
+    }
+
+    /* Opens a given output file, or gives stdout for "-" */
+    static ostream& openOutput(string fileName, ofstream& file) {
+        if (isStdStream(fileName)) {
+            return cout;
+        }
+        file.open(fileName, ios::binary);
+        return file;
+    }
 };
@@ -0,0 +1,134 @@
+/**
+ * Read only view of a whole input file in memory. Regular files are memory
+ * mapped so the file can be read as many times as needed without copying or
+ * reading it again from disk. Other inputs, and stdin given as "-", are read
+ * into a buffer once.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Class for MappedFile that gives access to all bytes of a file. Uses mmap
+ *  with a sequential access hint for regular files, and falls back to reading
+ *  the file into a buffer for inputs that cannot be mapped.
+ */
+class MappedFile {
+  private:
+    const byte* bytes;    // first byte of the file
+    size_t length;        // number of bytes in the file
+    void* mapping;        // mapped memory, nullptr if not mapped
+    vector<byte> buffer;  // file contents when the file could not be mapped
+    bool opened;          // whether the file could be opened
+
+    /* Reads everything left in the file descriptor into buffer.
+     * @param fd File descriptor to read from
+     */
+    void readAll(int fd) {
+        const size_t chunk = 1 << 16;  // bytes asked for in each read
+        size_t used = 0;
+        ssize_t got = 0;
+        do {
+            used += got;
+            buffer.resize(used + chunk);
+            got = read(fd, buffer.data() + used, chunk);
+        } while (got > 0);
+        buffer.resize(used);
+        bytes = buffer.data();
+        length = used;
+    }
+
+    /* Reads everything left in the stream into buffer.
+     * @param in istream to read from
+     */
+    void readAll(istream& in) {
+        const size_t chunk = 1 << 16;  // bytes asked for in each read
+        size_t used = 0;
+        do {
+            buffer.resize(used + chunk);
+            in.read((char*)buffer.data() + used, chunk);
+            used += in.gcount();
+        } while (in);
+        buffer.resize(used);
+        bytes = buffer.data();
+        length = used;
+    }
+
+  public:
+    /* Constructor of MappedFile.
+     * Opens the file and maps it or reads it into memory.
+     * @param fileName Name of the file to read, "-" for stdin
+     */
+    explicit MappedFile(const string& fileName)
+        : bytes(nullptr), length(0), mapping(nullptr), opened(false) {
+        if (fileName == "-") {  // through cin, which may hold bytes already
+            opened = true;
+            readAll(cin);
+            return;
+        }
+
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        opened = true;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+            info.st_size > 0) {
+            void* mapped =
+                mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+                mapping = mapped;
+                bytes = (const byte*)mapped;
+                length = info.st_size;
+            }
+        }
+        if (mapping == nullptr) {  // not mappable, read it the usual way
+            readAll(fd);
+        }
+        close(fd);
+    }
+
+    /* Deconstructor.
+     * Unmaps the file if it was mapped. */
+    ~MappedFile() {
+        if (mapping != nullptr) {
+            munmap(mapping, length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* Returns whether the file could be opened.
+     * @return true if opened
+     */
+    bool isOpen() const { return opened; }
+
+    /* Returns the first byte of the file.
+     * @return pointer to file contents
+     */
+    const byte* data() const { return bytes; }
+
+    /* Returns the number of bytes in the file.
+     * @return file size
+     */
+    size_t size() const { return length; }
+};
+
+#endif  // MAPPEDFILE_HPP
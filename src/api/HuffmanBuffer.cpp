@@ -0,0 +1,75 @@
+/**
+ * Library interface for compressing and decompressing buffers in memory.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "HuffmanBuffer.hpp"
+
+/* Compresses a buffer into the block container format, with an index.
+ * @param data First byte to compress
+ * @param size Number of bytes to compress
+ * @param out Vector to hold the compressed bytes, replacing its contents
+ * @param options Settings for compressing, stats are ignored
+ */
+void HuffmanBuffer::compressBuffer(const uint8_t* data, size_t size,
+                                   vector<uint8_t>& out,
+                                   const BlockCodec::Options& options) {
+    BlockCodec::Options settings = options;
+    settings.stats = nullptr;  // nothing to report them to
+
+    out.clear();
+    BitOutputStream outBit(out);
+    BlockCodec::compress(data, size, outBit, settings);
+    outBit.flush();
+}
+
+/* Returns how many bytes a compressed buffer decompresses to, so the caller
+ * can provide room for them.
+ * @param data First byte of the compressed buffer
+ * @param size Number of bytes in the compressed buffer
+ * @param decompressed Set to the number of decompressed bytes
+ * @return false if the buffer is not valid compressed data
+ */
+bool HuffmanBuffer::decompressedSize(const uint8_t* data, size_t size,
+                                     uint64_t& decompressed) {
+    return BlockCodec::decompressedSize(data, size, decompressed);
+}
+
+/* Decompresses a buffer into memory the caller provides.
+ * @param data First byte of the compressed buffer
+ * @param size Number of bytes in the compressed buffer
+ * @param out Where to write the decompressed bytes
+ * @param capacity Number of bytes out has room for
+ * @param threads Number of threads to decode blocks with
+ * @return false if the buffer is not valid compressed data or does not fit in
+ * capacity bytes
+ */
+bool HuffmanBuffer::decompressBuffer(const uint8_t* data, size_t size,
+                                     uint8_t* out, size_t capacity,
+                                     unsigned int threads) {
+    return BlockCodec::decompress(data, size, out, capacity, threads);
+}
+
+/* Decompresses a buffer into a vector.
+ * @param data First byte of the compressed buffer
+ * @param size Number of bytes in the compressed buffer
+ * @param out Vector to hold the decompressed bytes, replacing its contents
+ * @param threads Number of threads to decode blocks with
+ * @return false if the buffer is not valid compressed data
+ */
+bool HuffmanBuffer::decompressBuffer(const uint8_t* data, size_t size,
+                                     vector<uint8_t>& out,
+                                     unsigned int threads) {
+    uint64_t decompressed = 0;
+    if (!decompressedSize(data, size, decompressed)) {
+        out.clear();
+        return false;
+    }
+    out.resize(decompressed);
+    if (!BlockCodec::decompress(data, size, out.data(), out.size(), threads)) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
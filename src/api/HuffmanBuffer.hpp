@@ -0,0 +1,70 @@
+/**
+ * Header file of HuffmanBuffer, the library interface for compressing and
+ * decompressing buffers in memory. Reads and writes the same block container
+ * as compress and uncompress, without touching files or streams.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef HUFFMANBUFFER_HPP
+#define HUFFMANBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BlockCodec.hpp"
+
+using namespace std;
+
+/** Class for HuffmanBuffer that compresses a buffer into a vector and
+ *  decompresses it back, either into a vector or into memory the caller
+ *  provides.
+ */
+class HuffmanBuffer {
+  public:
+    /* Compresses a buffer into the block container format, with an index.
+     * @param data First byte to compress
+     * @param size Number of bytes to compress
+     * @param out Vector to hold the compressed bytes, replacing its contents
+     * @param options Settings for compressing, stats are ignored
+     */
+    static void compressBuffer(
+        const uint8_t* data, size_t size, vector<uint8_t>& out,
+        const BlockCodec::Options& options = BlockCodec::Options());
+
+    /* Returns how many bytes a compressed buffer decompresses to, so the
+     * caller can provide room for them.
+     * @param data First byte of the compressed buffer
+     * @param size Number of bytes in the compressed buffer
+     * @param decompressed Set to the number of decompressed bytes
+     * @return false if the buffer is not valid compressed data
+     */
+    static bool decompressedSize(const uint8_t* data, size_t size,
+                                 uint64_t& decompressed);
+
+    /* Decompresses a buffer into memory the caller provides.
+     * @param data First byte of the compressed buffer
+     * @param size Number of bytes in the compressed buffer
+     * @param out Where to write the decompressed bytes
+     * @param capacity Number of bytes out has room for
+     * @param threads Number of threads to decode blocks with
+     * @return false if the buffer is not valid compressed data or does not fit
+     * in capacity bytes
+     */
+    static bool decompressBuffer(const uint8_t* data, size_t size,
+                                 uint8_t* out, size_t capacity,
+                                 unsigned int threads = 1);
+
+    /* Decompresses a buffer into a vector.
+     * @param data First byte of the compressed buffer
+     * @param size Number of bytes in the compressed buffer
+     * @param out Vector to hold the decompressed bytes, replacing its contents
+     * @param threads Number of threads to decode blocks with
+     * @return false if the buffer is not valid compressed data
+     */
+    static bool decompressBuffer(const uint8_t* data, size_t size,
+                                 vector<uint8_t>& out,
+                                 unsigned int threads = 1);
+};
+
+#endif  // HUFFMANBUFFER_HPP
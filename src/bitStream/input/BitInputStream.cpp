@@ -1,33 +1,130 @@
 /**
- * Input stream that takes in a byte but reads bits one by one.
+ * Input stream that takes in bytes but reads bits one or several at a time.
  *
  * Author: Aimee T Shao
  * PID: A15444996
  */
 #include "BitInputStream.hpp"
 
-/* Fills the one byte buffer from the input stream. */
+#include <cstring>
+
+/* Moves the bytes not yet used to the front of the block and reads the input
+ * stream to fill up the rest of the block. */
+void BitInputStream::fillBlock() {
+    size_t left = end - next;
+    if (block.empty()) {
+        block.resize(BLOCK_SIZE);
+    } else if (left != 0) {
+        memmove(block.data(), next, left);
+    }
+
+    in->read((char*)block.data() + left, BLOCK_SIZE - left);
+    next = block.data();
+    end = next + left + in->gcount();
+    bytesRead += in->gcount();
+}
+
+/* Fills the bit buffer with the next bytes of input until it can no longer
+ * hold another whole byte. */
 void BitInputStream::fill() {
-    unsigned char temp = in.get();  // get unsigned ascii byte
-    buf = temp;                     // store into buffer
-    nbits = 0;  // we read bits starting from index 0 of buffer
+    if (end - next < (long)sizeof(buf) && in != nullptr && in->good()) {
+        fillBlock();
+    }
+
+    if (end - next >= (long)sizeof(buf)) {
+        // load a whole word at once, bits past the buffer's last whole byte
+        // are loaded again by the next fill
+        uint64_t word = 0;
+        for (unsigned int i = 0; i < sizeof(buf); i++) {
+            word = (word << BIT_IN_BYTE) | next[i];
+        }
+        buf |= word >> nbits;
+        next += (BUF_BITS - 1 - nbits) / BIT_IN_BYTE;
+        nbits |= BUF_BITS - BIT_IN_BYTE;
+        return;
+    }
+
+    // close to the end of input, anything past it is read as 0s
+    while (nbits <= BUF_BITS - BIT_IN_BYTE) {
+        uint64_t temp = 0;
+        if (next < end) {
+            temp = *next++;
+        } else {
+            zeros++;
+        }
+        buf |= temp << (BUF_BITS - BIT_IN_BYTE - nbits);
+        nbits += BIT_IN_BYTE;
+    }
 }
 
-/* Reads the next bit from the bit buffer. Fills buffer with next byte if
- * all the bits have been read.
+/* Reads the next bit from the bit buffer. Fills buffer if all the bits have
+ * been read.
  * @return 0 if bit read is 0, 1 if bit read is 1.*/
 unsigned int BitInputStream::readBit() {
     // fills buffer if all bits have been read
-    if (nbits == BIT_IN_BYTE) {
+    if (nbits == 0) {
         fill();
     }
 
-    // get bit at specific nbits location - shift loc to index 7, get last digit
-    unsigned char ubuf = buf;
-    unsigned int bit = (ubuf >> (BIT_IN_BYTE - 1 - nbits)) & 1;
-
-    // increment nbits
-    nbits++;
+    // next bit is the most significant bit of the buffer
+    unsigned int bit = buf >> (BUF_BITS - 1);
+    buf <<= 1;
+    nbits--;
 
     return bit;
-}
\ No newline at end of file
+}
+
+/* Reads the next n bits, first bit read as the most significant bit of the
+ * result.
+ * @param n Number of bits to read, at most 64
+ * @return the n bits read
+ */
+uint64_t BitInputStream::readBits(unsigned int n) {
+    const unsigned int maxPeek = 32;
+    if (n > maxPeek) {  // read the leading bits first
+        uint64_t high = readBits(n - maxPeek);
+        return (high << maxPeek) | readBits(maxPeek);
+    }
+
+    uint64_t bits = peekBits(n);
+    consumeBits(n);
+    return bits;
+}
+
+/* Reads whole bytes. Should only be called when the bits read so far fill
+ * whole bytes.
+ * @param data Where to copy the bytes read
+ * @param size Number of bytes to read
+ */
+void BitInputStream::readBytes(byte* data, size_t size) {
+    // bytes already moved into the bit buffer come first
+    while (size > 0 && nbits >= BIT_IN_BYTE) {
+        *data++ = buf >> (BUF_BITS - BIT_IN_BYTE);
+        consumeBits(BIT_IN_BYTE);
+        size--;
+    }
+    if (size == 0) {  // bit buffer may still hold the bytes after these
+        return;
+    }
+    buf = 0;  // drop bits loaded past nbits, next is about to move on
+    nbits = 0;
+
+    while (size > 0) {
+        if (next == end) {
+            if (in == nullptr || !in->good()) {  // past the end, read 0s
+                memset(data, 0, size);
+                return;
+            }
+            fillBlock();
+            continue;
+        }
+        size_t count = end - next;
+        if (count > size) {
+            count = size;
+        }
+        memcpy(data, next, count);
+        next += count;
+        data += count;
+        size -= count;
+    }
+}
@@ -1,5 +1,5 @@
 /**
- * Input stream that takes in a byte but reads bits one by one.
+ * Input stream that takes in bytes but reads bits one or several at a time.
  *
  * Author: Aimee T Shao
  * PID: A15444996
@@ -7,35 +7,129 @@
 #ifndef BITINPUTSTREAM_HPP
 #define BITINPUTSTREAM_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 typedef unsigned char byte;
 
 using namespace std;
 
 /** Class for BitInputStream that reads bits instead of the standard byte.
- *  Stores a byte into a buffer and reads bits one at a time.
+ *  Reads bytes either from a block of memory or from an input stream in large
+ *  blocks, and keeps up to 64 bits of lookahead in a buffer so that callers can
+ *  read bits one at a time or peek at several upcoming bits at once. Reading
+ *  past the end of the input gives 0 bits.
  */
 class BitInputStream {
   private:
-    char buf;     // one byte buffer of bits
-    int nbits;    // number of bits have been written to buf
-    istream& in;  // reference to the input stream to use
+    uint64_t buf;        // lookahead bits, next bit to read is most significant
+    int nbits;           // number of valid bits left in buf
+    int zeros;           // bytes of 0s put in buf from past the end of input
+    const byte* next;    // next byte of input to move into buf
+    const byte* end;     // one past the last byte of input available
+    vector<byte> block;  // block of bytes read from in
+    istream* in;         // input stream to use, nullptr if reading memory
+    uint64_t bytesRead;  // bytes taken from in, or size of memory to read
     static const int BIT_IN_BYTE = 8;
+    static const int BUF_BITS = 64;
+    static const size_t BLOCK_SIZE = 1 << 16;  // bytes read from in at once
+
+    /* Moves the bytes not yet used to the front of the block and reads the
+     * input stream to fill up the rest of the block. */
+    void fillBlock();
 
   public:
     /* Constructor of BitInputStream.
      * Initializes values of buffer, nbits, and in stream.
      * @param is Reference to input stream to use
      */
-    explicit BitInputStream(istream& is) : buf(0), nbits(BIT_IN_BYTE), in(is){};
+    explicit BitInputStream(istream& is)
+        : buf(0),
+          nbits(0),
+          zeros(0),
+          next(0),
+          end(0),
+          in(&is),
+          bytesRead(0){};
+
+    /* Constructor of BitInputStream reading from memory. The memory must stay
+     * valid while the stream is used.
+     * @param data First byte to read
+     * @param size Number of bytes that can be read
+     */
+    BitInputStream(const byte* data, size_t size)
+        : buf(0),
+          nbits(0),
+          zeros(0),
+          next(data),
+          end(data + size),
+          in(nullptr),
+          bytesRead(size){};
 
-    /* Fills the one byte buffer from the input stream. */
+    /* Fills the bit buffer with the next bytes of input until it can no longer
+     * hold another whole byte. */
     void fill();
 
-    /* Reads the next bit from the bit buffer. Fills buffer with next byte if
-     * all the bits have been read.
+    /* Reads the next bit from the bit buffer. Fills buffer if all the bits
+     * have been read.
      * @return 0 if bit read is 0, 1 if bit read is 1.*/
     unsigned int readBit();
+
+    /* Returns the next n bits without consuming them, first bit read as the
+     * most significant bit of the result.
+     * @param n Number of bits to look at, at most 32
+     * @return the next n bits as an unsigned int
+     */
+    unsigned int peekBits(unsigned int n) {
+        if ((unsigned int)nbits < n) {
+            fill();
+        }
+        return n == 0 ? 0 : buf >> (BUF_BITS - n);
+    }
+
+    /* Skips the next n bits. Should only be called with n no greater than the
+     * amount of bits last peeked.
+     * @param n Number of bits to consume
+     */
+    void consumeBits(unsigned int n) {
+        buf <<= n;
+        nbits -= n;
+    }
+
+    /* Skips the rest of the byte being read, so reading goes on from the
+     * start of the next byte.
+     */
+    void skipToByte() { consumeBits(nbits % BIT_IN_BYTE); }
+
+    /* Returns how many whole bytes are left to read from memory. Should only
+     * be called on a stream reading from memory, at a byte boundary.
+     * @return number of bytes not read yet
+     */
+    size_t bytesLeft() const {
+        int inBuf = nbits / BIT_IN_BYTE;  // 0s past the end come after the rest
+        return (end - next) + inBuf - (zeros < inBuf ? zeros : inBuf);
+    }
+
+    /* Returns how many bytes the stream has taken from its input so far,
+     * counting bytes read ahead but not used yet. A stream reading memory has
+     * taken all of it.
+     * @return number of input bytes taken
+     */
+    uint64_t getBytesRead() const { return bytesRead; }
+
+    /* Reads the next n bits, first bit read as the most significant bit of
+     * the result.
+     * @param n Number of bits to read, at most 64
+     * @return the n bits read
+     */
+    uint64_t readBits(unsigned int n);
+
+    /* Reads whole bytes. Should only be called when the bits read so far fill
+     * whole bytes.
+     * @param data Where to copy the bytes read
+     * @param size Number of bytes to read
+     */
+    void readBytes(byte* data, size_t size);
 };
 
-#endif
\ No newline at end of file
+#endif
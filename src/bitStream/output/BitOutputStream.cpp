@@ -1,31 +1,125 @@
 /**
- * Output stream that writes bits one by one.
+ * Output stream that writes bits one by one or several at a time.
  *
  * Author: Aimee T Shao
  * PID: A15444996
  */
 #include "BitOutputStream.hpp"
 
-/* Sends buffer to output stream and clears buffer. */
+#include <cstring>
+
+/* Moves the full 64 bit register into the byte buffer, writing the byte buffer
+ * to the output stream first if it has no room left. */
+void BitOutputStream::flushWord() {
+    if (nbytes + sizeof(buf) > bytes.size()) {
+        flushBytes();
+    }
+
+    // store word most significant byte first
+    for (int shift = BUF_BITS - BIT_IN_BYTE; shift >= 0; shift -= BIT_IN_BYTE) {
+        bytes[nbytes++] = buf >> shift;
+    }
+    buf = 0;
+    nbits = 0;
+}
+
+/* Moves the bytes of the register that hold written bits into the byte buffer,
+ * padding the last one with 0s. */
+void BitOutputStream::flushBits() {
+    if (nbytes + sizeof(buf) > bytes.size()) {
+        flushBytes();
+    }
+
+    // copy over bytes of register that hold at least one written bit
+    for (int written = 0; written < nbits; written += BIT_IN_BYTE) {
+        bytes[nbytes++] = buf >> (BUF_BITS - BIT_IN_BYTE - written);
+    }
+    buf = 0;    // clear buffer
+    nbits = 0;  // reset nbits
+}
+
+/* Writes the byte buffer to the output stream and clears it. */
+void BitOutputStream::flushBytes() {
+    writeOut(bytes.data(), nbytes);
+    nbytes = 0;
+}
+
+/* Writes bytes to the output stream or destination vector.
+ * @param data First byte to write
+ * @param size Number of bytes to write
+ */
+void BitOutputStream::writeOut(const byte* data, size_t size) {
+    flushedBytes += size;
+    if (out != nullptr) {
+        out->write((const char*)data, size);
+    } else {
+        dest->insert(dest->end(), data, data + size);
+    }
+}
+
+/* Pads the last partial byte with 0s, sends every buffered byte to output
+ * stream and clears buffers. The output stream is flushed too, so what was
+ * written reaches its reader. */
 void BitOutputStream::flush() {
-    out << buf;  // write buffer to outstream
-    buf = 0;     // clear buffer
-    nbits = 0;   // reset nbits
+    flushBits();
+    flushBytes();  // write buffer to outstream
+    if (out != nullptr) {
+        out->flush();
+    }
 }
 
 /* Writes least significant bit of given int to bit buffer. Flushes buffer
  * if full.
  * @param i Bit to write.
  */
-void BitOutputStream::writeBit(int i) {
-    // write least significant bit to buffer at nbits
-    buf = (i << (BIT_IN_BYTE - 1 - nbits)) | buf;
+void BitOutputStream::writeBit(int i) { writeBits(i, 1); }
+
+/* Writes the len least significant bits of code to bit buffer, most
+ * significant of those bits first.
+ * @param code Bits to write, right aligned
+ * @param len Number of bits to write, at most 64
+ */
+void BitOutputStream::writeBits(uint64_t code, unsigned int len) {
+    if (len == 0) {
+        return;
+    }
+    if (len < (unsigned int)BUF_BITS) {  // drop bits above the ones to write
+        code &= ((uint64_t)1 << len) - 1;
+    }
 
-    // increment nbits
-    nbits++;
+    unsigned int room = BUF_BITS - nbits;  // bits left in register
+    if (len < room) {  // fits in register, place right after written bits
+        buf |= code << (room - len);
+        nbits += len;
+        return;
+    }
+
+    // fill up register with the leading bits, then start over with the rest
+    unsigned int rest = len - room;
+    buf |= code >> rest;
+    nbits = BUF_BITS;
+    flushWord();
+    if (rest != 0) {
+        buf = code << (BUF_BITS - rest);
+        nbits = rest;
+    }
+}
+
+/* Writes whole bytes. Should only be called when the bits written so far fill
+ * whole bytes.
+ * @param data First byte to write
+ * @param size Number of bytes to write
+ */
+void BitOutputStream::writeBytes(const byte* data, size_t size) {
+    flushBits();
+    if (nbytes + size > bytes.size()) {
+        flushBytes();
+    }
 
-    // check if buffer is full
-    if (nbits == BIT_IN_BYTE) {
-        flush();
+    if (size >= bytes.size()) {  // too big to be worth buffering
+        writeOut(data, size);
+    } else if (size != 0) {
+        memcpy(bytes.data() + nbytes, data, size);
+        nbytes += size;
     }
 }
@@ -1,5 +1,5 @@
 /**
- * Output stream that writes bits one by one.
+ * Output stream that writes bits one by one or several at a time.
  *
  * Author: Aimee T Shao
  * PID: A15444996
@@ -7,30 +7,79 @@
 #ifndef BITOUTPUTSTREAM_HPP
 #define BITOUTPUTSTREAM_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 typedef unsigned char byte;
 
 using namespace std;
 
 /** Class for BitOutputStream that writes bits instead of the standard byte.
- *  Stores a byte into a buffer and writes bits one at a time.
+ *  Accumulates bits in a 64 bit register, moves every full word into a large
+ *  byte buffer and only hands that buffer to the output stream, or appends it
+ *  to a vector in memory, in big chunks.
  */
 class BitOutputStream {
   private:
-    char buf;      // one byte buffer of bits
-    int nbits;     // number of bits have been writen to buf
-    ostream& out;  // reference to the output stream to use
+    uint64_t buf;           // pending bits, first written is most significant
+    int nbits;              // number of bits have been writen to buf
+    vector<byte> bytes;     // whole bytes waiting to be written to out
+    size_t nbytes;          // number of bytes used in bytes
+    uint64_t flushedBytes;  // number of bytes handed to out or dest so far
+    ostream* out;           // output stream to use, nullptr if writing memory
+    vector<byte>* dest;     // vector to append to when writing memory
     static const int BIT_IN_BYTE = 8;
+    static const int BUF_BITS = 64;
+    static const size_t BYTES_SIZE = 1 << 16;  // bytes handed to out at once
+
+    /* Moves the full 64 bit register into the byte buffer, writing the byte
+     * buffer to the output stream first if it has no room left. */
+    void flushWord();
+
+    /* Moves the bytes of the register that hold written bits into the byte
+     * buffer, padding the last one with 0s. */
+    void flushBits();
+
+    /* Writes the byte buffer to the output stream and clears it. */
+    void flushBytes();
+
+    /* Writes bytes to the output stream or destination vector.
+     * @param data First byte to write
+     * @param size Number of bytes to write
+     */
+    void writeOut(const byte* data, size_t size);
 
   public:
     /* Constructor of BitOutputStream.
      * Initializes values of buffer, nbits, and out stream.
      * @param out Reference to output stream to use
      */
-    explicit BitOutputStream(ostream& os) : buf(0), nbits(0), out(os){};
+    explicit BitOutputStream(ostream& os)
+        : buf(0),
+          nbits(0),
+          bytes(BYTES_SIZE),
+          nbytes(0),
+          flushedBytes(0),
+          out(&os),
+          dest(nullptr){};
+
+    /* Constructor of BitOutputStream writing to memory.
+     * Bytes written are appended to the given vector.
+     * @param vec Reference to vector to append to
+     */
+    explicit BitOutputStream(vector<byte>& vec)
+        : buf(0),
+          nbits(0),
+          bytes(BYTES_SIZE),
+          nbytes(0),
+          flushedBytes(0),
+          out(nullptr),
+          dest(&vec){};
 
-    /* Sends buffer to output stream and clears buffer. */
+    /* Pads the last partial byte with 0s, sends every buffered byte to output
+     * stream and clears buffers. The output stream is flushed too, so what was
+     * written reaches its reader. */
     void flush();
 
     /* Writes least significant bit of given int to bit buffer. Flushes buffer
@@ -38,6 +87,35 @@ class BitOutputStream {
      * @param i Bit to write.
      */
     void writeBit(int i);
+
+    /* Writes the len least significant bits of code to bit buffer, most
+     * significant of those bits first.
+     * @param code Bits to write, right aligned
+     * @param len Number of bits to write, at most 64
+     */
+    void writeBits(uint64_t code, unsigned int len);
+
+    /* Writes whole bytes. Should only be called when the bits written so far
+     * fill whole bytes.
+     * @param data First byte to write
+     * @param size Number of bytes to write
+     */
+    void writeBytes(const byte* data, size_t size);
+
+    /* Returns how many bytes have been written so far, counting a partly
+     * written last byte as a whole byte.
+     * @return number of bytes written
+     */
+    uint64_t getBytesWritten() const {
+        return flushedBytes + nbytes + (nbits + BIT_IN_BYTE - 1) / BIT_IN_BYTE;
+    }
+
+    /* Returns how many bits have been written so far.
+     * @return number of bits written
+     */
+    uint64_t getBitsWritten() const {
+        return (flushedBytes + nbytes) * BIT_IN_BYTE + nbits;
+    }
 };
 
 #endif
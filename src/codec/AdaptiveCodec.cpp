@@ -0,0 +1,93 @@
+/**
+ * Single pass format for Huffman compressed files, coded with an adaptive
+ * Huffman tree.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "AdaptiveCodec.hpp"
+
+#include "BlockCodec.hpp"
+#include "Histogram.hpp"
+
+#define ASCII_MAX 256  // number of byte values
+
+const unsigned int AdaptiveCodec::VERSION;
+const size_t AdaptiveCodec::CHUNK_SIZE;
+
+/* Compresses everything left in an input stream, from the magic to the end
+ * chunk. Each chunk is written out as soon as whatever input is available has
+ * been read, without waiting for a full chunk.
+ * @param in istream to read the input from
+ * @param out BitOutputStream to write the compressed file to
+ * @param stats Where to time phases and count symbols, nullptr for none
+ */
+void AdaptiveCodec::compress(istream& in, BitOutputStream& out, Stats* stats) {
+    out.writeBits(BlockCodec::MAGIC, BlockCodec::MAGIC_BITS);
+    out.writeBits(VERSION, BlockCodec::VERSION_BITS);
+
+    AdaptiveHCTree tree;  // same tree for every chunk
+    byte chunk[CHUNK_SIZE];
+    size_t size;
+    while ((size = readChunk(in, chunk)) > 0) {
+        Stats::Timer code(stats, Stats::CODE);
+        BlockCodec::writeVarint(out, size);
+        uint64_t start = out.getBitsWritten();
+        for (size_t i = 0; i < size; i++) {
+            tree.encode(chunk[i], out);
+        }
+        code.stop();
+        if (stats != nullptr) {  // symbols are only counted for stats
+            Stats::Timer timer(stats, Stats::HISTOGRAM);
+            vector<uint64_t> freqs(ASCII_MAX);
+            Histogram::count(chunk, size, freqs);
+            stats->addCoded(freqs, out.getBitsWritten() - start);
+        }
+        Stats::Timer flush(stats, Stats::FLUSH);
+        out.flush();  // pad the chunk and hand it to the reader
+    }
+    BlockCodec::writeVarint(out, 0);  // end chunk
+}
+
+/* Decompresses a file whose magic and version have already been read.
+ * @param in BitInputStream positioned right after the version
+ * @param out ostream to write the decompressed bytes to
+ * @return false if a chunk is longer than chunks can be
+ */
+bool AdaptiveCodec::decompress(BitInputStream& in, ostream& out) {
+    AdaptiveHCTree tree;  // updated the same way as the compressor's
+    byte chunk[CHUNK_SIZE];
+    uint64_t size;
+    while ((size = BlockCodec::readVarint(in)) > 0) {
+        if (size > CHUNK_SIZE) {
+            return false;
+        }
+        for (uint64_t i = 0; i < size; i++) {
+            chunk[i] = tree.decode(in);
+        }
+        out.write((const char*)chunk, size);
+        in.skipToByte();  // chunks are padded to a whole byte
+    }
+    return true;
+}
+
+/* Reads the next chunk of input. Waits for at least one byte, then takes only
+ * the bytes already available, up to CHUNK_SIZE.
+ * @param in istream to read from
+ * @param chunk Buffer of CHUNK_SIZE bytes to read into
+ * @return number of bytes read, 0 at the end of the input
+ */
+size_t AdaptiveCodec::readChunk(istream& in, byte* chunk) {
+    int first = in.get();  // blocks until input arrives or ends
+    if (first == EOF) {
+        return 0;
+    }
+    chunk[0] = first;
+    size_t size = 1;
+    streamsize got;
+    while (size < CHUNK_SIZE &&
+           (got = in.readsome((char*)chunk + size, CHUNK_SIZE - size)) > 0) {
+        size += got;
+    }
+    return size;
+}
@@ -0,0 +1,62 @@
+/**
+ * Single pass format for Huffman compressed files, coded with an adaptive
+ * Huffman tree so no code has to be known before the first symbol is written.
+ *
+ * A compressed file starts with the 32 bit magic and an 8 bit version, like
+ * the block container. Chunks of the input follow, each holding its number of
+ * symbols as a variable length integer, then the symbols coded with the
+ * adaptive tree, padded to a whole byte. The tree goes on from one chunk to
+ * the next, so chunks only bound how much input is held at once and are
+ * handed out as soon as they are coded. A chunk with 0 symbols ends the file.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef ADAPTIVECODEC_HPP
+#define ADAPTIVECODEC_HPP
+
+#include <cstdint>
+#include <iostream>
+#include "AdaptiveHCTree.hpp"
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "Stats.hpp"
+
+using namespace std;
+
+/** Class for AdaptiveCodec that reads and writes the single pass format.
+ *  Compresses an input stream of any length with constant memory.
+ */
+class AdaptiveCodec {
+  public:
+    static const unsigned int VERSION = 3;  // version of single pass format
+    static const size_t CHUNK_SIZE = 1 << 16;  // most bytes of input per chunk
+
+    /* Compresses everything left in an input stream, from the magic to the
+     * end chunk. Each chunk is written out as soon as whatever input is
+     * available has been read, without waiting for a full chunk.
+     * @param in istream to read the input from
+     * @param out BitOutputStream to write the compressed file to
+     * @param stats Where to time phases and count symbols, nullptr for none
+     */
+    static void compress(istream& in, BitOutputStream& out,
+                         Stats* stats = nullptr);
+
+    /* Decompresses a file whose magic and version have already been read.
+     * @param in BitInputStream positioned right after the version
+     * @param out ostream to write the decompressed bytes to
+     * @return false if a chunk is longer than chunks can be
+     */
+    static bool decompress(BitInputStream& in, ostream& out);
+
+  private:
+    /* Reads the next chunk of input. Waits for at least one byte, then takes
+     * only the bytes already available, up to CHUNK_SIZE.
+     * @param in istream to read from
+     * @param chunk Buffer of CHUNK_SIZE bytes to read into
+     * @return number of bytes read, 0 at the end of the input
+     */
+    static size_t readChunk(istream& in, byte* chunk);
+};
+
+#endif  // ADAPTIVECODEC_HPP
@@ -0,0 +1,1043 @@
+/**
+ * Block container format for Huffman compressed files. The input is split into
+ * fixed size blocks and each block is compressed on its own with its own
+ * canonical code.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "BlockCodec.hpp"
+
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "ContextHCTree.hpp"
+#include "HCTree.hpp"
+
+#define ASCII_MAX 256         // number of ascii values for HCTree
+#define BIT_IN_BYTE 8         // bits written per varint byte
+#define VARINT_DATA_BITS 7    // bits of the value held by each varint byte
+#define VARINT_MORE 0x80      // set in varint bytes followed by another byte
+#define VARINT_MAX_BYTES 10   // bytes needed for the largest 64 bit value
+
+// definitions for constants that get bound to references
+const uint32_t BlockCodec::MAGIC;
+const unsigned int BlockCodec::MAGIC_BITS;
+const unsigned int BlockCodec::VERSION;
+const unsigned int BlockCodec::VERSION_BITS;
+const unsigned int BlockCodec::FLAGS_BITS;
+const unsigned int BlockCodec::FLAG_INDEX;
+const unsigned int BlockCodec::FLAG_RESTARTS;
+const unsigned int BlockCodec::FLAG_STREAMS;
+const unsigned int BlockCodec::FLAG_CONTEXT;
+const unsigned int BlockCodec::INDEX_OFFSET_BITS;
+const size_t BlockCodec::DEFAULT_BLOCK_SIZE;
+const size_t BlockCodec::MAX_BLOCK_SIZE;
+const size_t BlockCodec::DEFAULT_RESTART_INTERVAL;
+
+/* Compresses all of data, from the magic to the index. With more than one
+ * thread, blocks are encoded by a pool of worker threads and written out in
+ * order as they finish.
+ * @param data First byte to compress
+ * @param size Number of bytes to compress
+ * @param out BitOutputStream to write the compressed file to
+ * @param options Settings for compressing
+ */
+void BlockCodec::compress(const byte* data, size_t size, BitOutputStream& out,
+                          const Options& options) {
+    uint64_t start = out.getBytesWritten();
+    vector<BlockEntry> index;
+    {
+        Stats::Timer timer(options.stats, Stats::HEADER);
+        writeHeader(out, options);
+    }
+    uint64_t firstBlockOffset = out.getBytesWritten() - start;
+
+    if (options.threads > 1 && size > options.blockSize) {
+        compressParallel(data, size, out, options, start, index);
+    } else {
+        vector<byte> payload;  // reused for every block
+        vector<uint64_t> restarts;
+        for (size_t pos = 0; pos < size; pos += options.blockSize) {
+            size_t blockSize = min(options.blockSize, size - pos);
+            payload.clear();
+            restarts.clear();
+            encodeBlock(data + pos, blockSize, options, payload, restarts);
+            Stats::Timer timer(options.stats, Stats::CODE);
+            writeBlock(out, blockSize, payload, restarts, start, index);
+        }
+    }
+    Stats::Timer timer(options.stats, Stats::HEADER);
+    writeIndex(out, start, firstBlockOffset, index);
+}
+
+/* Compresses everything left in an input stream, one block at a time. Only
+ * one block of input is held in memory, and each block is written out and
+ * flushed before the next one is read.
+ * @param in istream to read the input from
+ * @param out BitOutputStream to write the compressed file to
+ * @param options Settings for compressing
+ */
+void BlockCodec::compress(istream& in, BitOutputStream& out,
+                          const Options& options) {
+    uint64_t start = out.getBytesWritten();
+    vector<BlockEntry> index;
+    {
+        Stats::Timer timer(options.stats, Stats::HEADER);
+        writeHeader(out, options);
+    }
+    uint64_t firstBlockOffset = out.getBytesWritten() - start;
+
+    vector<byte> block(options.blockSize);  // reused for every block
+    vector<byte> payload;
+    vector<uint64_t> restarts;
+    while (in.read((char*)block.data(), block.size()) || in.gcount() > 0) {
+        size_t blockSize = in.gcount();
+        payload.clear();
+        restarts.clear();
+        encodeBlock(block.data(), blockSize, options, payload, restarts);
+        Stats::Timer timer(options.stats, Stats::CODE);
+        writeBlock(out, blockSize, payload, restarts, start, index);
+        out.flush();  // blocks end on a byte, send this one on to the reader
+    }
+    Stats::Timer timer(options.stats, Stats::HEADER);
+    writeIndex(out, start, firstBlockOffset, index);
+}
+
+/* Writes the magic, version, flags, block size and restart interval.
+ * @param out BitOutputStream to write to
+ * @param options Settings for compressing
+ */
+void BlockCodec::writeHeader(BitOutputStream& out, const Options& options) {
+    out.writeBits(MAGIC, MAGIC_BITS);
+    out.writeBits(VERSION, VERSION_BITS);
+    unsigned int flags = FLAG_INDEX;
+    // neither contexts nor sub-streams can restart in the middle
+    if (options.context) {
+        flags |= FLAG_CONTEXT;
+    } else if (options.interleave) {
+        flags |= FLAG_STREAMS;
+    } else if (options.restartInterval != 0) {
+        flags |= FLAG_RESTARTS;
+    }
+    out.writeBits(flags, FLAGS_BITS);
+    writeVarint(out, options.blockSize);
+    if (flags & FLAG_RESTARTS) {
+        writeVarint(out, options.restartInterval);
+    }
+}
+
+/* Writes the end block, the index and where the index starts.
+ * @param out BitOutputStream to write to
+ * @param start Bytes written to out before the magic
+ * @param firstBlockOffset Offset of the first block from the magic
+ * @param index Entries of every block written
+ */
+void BlockCodec::writeIndex(BitOutputStream& out, uint64_t start,
+                            uint64_t firstBlockOffset,
+                            const vector<BlockEntry>& index) {
+    writeVarint(out, 0);  // end block
+
+    uint64_t indexOffset = out.getBytesWritten() - start;
+    writeVarint(out, index.size());
+    writeVarint(out, firstBlockOffset);
+    for (const BlockEntry& entry : index) {
+        writeVarint(out, entry.bytes);
+        writeVarint(out, entry.symbols);
+
+        uint64_t previous = 0;  // restart points as distances from previous
+        for (uint64_t restart : entry.restarts) {
+            writeVarint(out, restart - previous);
+            previous = restart;
+        }
+    }
+    out.writeBits(indexOffset, INDEX_OFFSET_BITS);
+}
+
+/* Writes one block and records where it went in the index.
+ * @param out BitOutputStream to write to
+ * @param symbols Number of symbols in the block
+ * @param payload Payload of the block
+ * @param restarts Bit offsets of the block's restart points
+ * @param start Bytes written to out before the magic
+ * @param index Vector to add the block's entry to
+ */
+void BlockCodec::writeBlock(BitOutputStream& out, uint64_t symbols,
+                            const vector<byte>& payload,
+                            const vector<uint64_t>& restarts, uint64_t start,
+                            vector<BlockEntry>& index) {
+    uint64_t offset = out.getBytesWritten() - start;
+    writeVarint(out, symbols);
+    writeVarint(out, payload.size());
+    out.writeBytes(payload.data(), payload.size());
+    index.push_back(BlockEntry{
+        offset, out.getBytesWritten() - start - offset, symbols, restarts});
+}
+
+/* Encodes every block on a pool of worker threads and writes them out in
+ * order. Only a few blocks more than there are threads are held in memory at a
+ * time.
+ * @param data First byte to compress
+ * @param size Number of bytes to compress
+ * @param out BitOutputStream to write the blocks to
+ * @param options Settings for compressing
+ * @param start Bytes written to out before the magic
+ * @param index Vector to add the blocks' entries to
+ */
+void BlockCodec::compressParallel(const byte* data, size_t size,
+                                  BitOutputStream& out, const Options& options,
+                                  uint64_t start, vector<BlockEntry>& index) {
+    size_t blocks = (size + options.blockSize - 1) / options.blockSize;
+    size_t window = 2 * options.threads;  // blocks held in memory at most
+
+    // each block goes to slot block % window until it is written out
+    vector<vector<byte>> payloads(window);
+    vector<vector<uint64_t>> restarts(window);
+    vector<bool> ready(window);
+    size_t nextBlock = 0;  // next block for a worker to take
+    size_t written = 0;    // number of blocks written out
+    mutex lock;
+    condition_variable changed;
+
+    // blocks are counted on their worker's thread alone
+    Options blockOptions = options;
+    blockOptions.threads = 1;
+
+    auto worker = [&]() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            // wait until there is a block to take whose slot is free
+            changed.wait(guard, [&]() {
+                return nextBlock >= blocks || nextBlock < written + window;
+            });
+            if (nextBlock >= blocks) {
+                return;
+            }
+            size_t block = nextBlock++;
+            guard.unlock();
+
+            size_t pos = block * options.blockSize;
+            encodeBlock(data + pos, min(options.blockSize, size - pos),
+                        blockOptions, payloads[block % window],
+                        restarts[block % window]);
+
+            guard.lock();
+            ready[block % window] = true;
+            changed.notify_all();
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int i = 0; i < options.threads; i++) {
+        workers.emplace_back(worker);
+    }
+
+    // write blocks in order as soon as each is ready
+    for (size_t block = 0; block < blocks; block++) {
+        size_t slot = block % window;
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [&]() { return ready[slot]; });
+        }
+
+        size_t pos = block * options.blockSize;
+        {
+            Stats::Timer timer(options.stats, Stats::CODE);
+            writeBlock(out, min(options.blockSize, size - pos), payloads[slot],
+                       restarts[slot], start, index);
+        }
+        payloads[slot].clear();
+        restarts[slot].clear();
+
+        lock_guard<mutex> guard(lock);
+        ready[slot] = false;
+        written++;
+        changed.notify_all();
+    }
+
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/* Decompresses a file whose magic and version have already been read.
+ * @param in BitInputStream positioned right after the version
+ * @param out ostream to write the decompressed bytes to
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the file is not a valid compressed file
+ */
+bool BlockCodec::decompress(BitInputStream& in, ostream& out, Stats* stats) {
+    Header header;  // restart points are only used through the index
+    {
+        Stats::Timer timer(stats, Stats::PROBE);
+        if (!readHeader(in, header)) {
+            return false;
+        }
+    }
+    uint64_t maxBlockSize = header.blockSize;
+
+    vector<byte> payload;  // reused for every block
+    vector<byte> decoded;
+    uint64_t symbols = readVarint(in);
+    while (symbols != 0) {
+        if (symbols > maxBlockSize) {
+            return false;
+        }
+        uint64_t payloadSize = readVarint(in);
+        if (payloadSize > maxPayloadSize(symbols, header.flags)) {
+            return false;  // longer than even 64 bit codes could make it
+        }
+
+        payload.resize(payloadSize);
+        in.readBytes(payload.data(), payloadSize);
+        decoded.resize(symbols);
+        if (!decodeBlock(payload.data(), payloadSize, decoded.data(), symbols,
+                         header.flags, stats)) {
+            return false;
+        }
+        Stats::Timer timer(stats, Stats::CODE);
+        out.write((const char*)decoded.data(), symbols);
+
+        symbols = readVarint(in);
+    }
+    return true;
+}
+
+/* Returns the most bytes a block's payload can take: the longest header, every
+ * symbol coded with the longest code, and padding.
+ * @param symbols Number of symbols in the block
+ * @param flags Flags of the file, saying how the block is coded
+ * @return most bytes of the payload
+ */
+uint64_t BlockCodec::maxPayloadSize(uint64_t symbols, unsigned int flags) {
+    uint64_t headerBits = HCTree::MAX_HEADER_BITS;
+    if (flags & FLAG_CONTEXT) {
+        headerBits = ContextHCTree::MAX_HEADER_BITS;
+    }
+    uint64_t bytes = headerBits / BIT_IN_BYTE + 1;
+    if (flags & FLAG_STREAMS) {  // sizes of the sub-streams, each padded
+        bytes += HCTree::INTERLEAVED_STREAMS * (VARINT_MAX_BYTES + 1);
+    }
+    return bytes + symbols * (HCTree::MAX_CODE_LENGTH / BIT_IN_BYTE) + 1;
+}
+
+/* Decompresses a whole compressed file from its already read index. Blocks are
+ * decoded by a pool of worker threads, each block written straight to its
+ * place in the output file. Every block is checked before the pool starts.
+ * @param file First byte of the compressed file, the magic
+ * @param blocks Where each block is, as read by readIndex
+ * @param header Settings in the file's header, as read by readIndex
+ * @param fd File descriptor of the output file, opened for writing
+ * @param threads Number of threads to decode with
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the blocks are not valid or could not be written
+ */
+bool BlockCodec::decompressParallel(const byte* file,
+                                    const vector<BlockEntry>& blocks,
+                                    const Header& header, int fd,
+                                    unsigned int threads, Stats* stats) {
+    vector<uint64_t> outOffsets;
+    if (!blockOffsets(blocks, header, outOffsets) ||
+        outOffsets.back() > (uint64_t)numeric_limits<off_t>::max() ||
+        ftruncate(fd, outOffsets.back()) != 0) {
+        return false;
+    }
+
+    return runPool(blocks.size(), threads, [&](size_t i) {
+        vector<byte> decoded(blocks[i].symbols);
+        if (!decodeIndexedBlock(file, blocks[i], decoded.data(), header.flags,
+                                stats)) {
+            return false;
+        }
+
+        // write the whole block at its offset, pwrite may write less
+        Stats::Timer timer(stats, Stats::CODE);
+        size_t done = 0;
+        while (done < blocks[i].symbols) {
+            ssize_t count = pwrite(fd, decoded.data() + done,
+                                   blocks[i].symbols - done,
+                                   outOffsets[i] + done);
+            if (count <= 0) {
+                return false;
+            }
+            done += count;
+        }
+        return true;
+    });
+}
+
+/* Decompresses a whole compressed file that has an index into memory. Blocks
+ * are decoded by a pool of worker threads, each block straight into its place
+ * in out.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param out Where to write the decompressed bytes
+ * @param capacity Number of bytes out has room for
+ * @param threads Number of threads to decode with
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the file is not a valid compressed file with an index, or
+ * it decompresses to more than capacity bytes
+ */
+bool BlockCodec::decompress(const byte* file, size_t size, byte* out,
+                            size_t capacity, unsigned int threads,
+                            Stats* stats) {
+    vector<BlockEntry> blocks;
+    Header header;
+    vector<uint64_t> outOffsets;
+    if (!readBlockOffsets(file, size, blocks, header, outOffsets, stats)) {
+        return false;
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {  // every block must fit
+        if (outOffsets[i] + blocks[i].symbols > capacity) {
+            return false;
+        }
+    }
+
+    return runPool(blocks.size(), threads, [&](size_t i) {
+        return decodeIndexedBlock(file, blocks[i], out + outOffsets[i],
+                                  header.flags, stats);
+    });
+}
+
+/* Returns how many bytes a compressed file with an index decompresses to.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param symbols Set to the number of decompressed bytes
+ * @return false if the file is not a valid compressed file with an index
+ */
+bool BlockCodec::decompressedSize(const byte* file, size_t size,
+                                  uint64_t& symbols) {
+    vector<BlockEntry> blocks;
+    Header header;
+    vector<uint64_t> outOffsets;
+    if (!readBlockOffsets(file, size, blocks, header, outOffsets)) {
+        return false;
+    }
+    symbols = outOffsets.back();
+    return true;
+}
+
+/* Reads the index of a compressed file and where each block's output starts.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param blocks Vector to store where each block is
+ * @param header Set to the settings in the file's header
+ * @param outOffsets Set to the output offset of each block, then the total
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the file has no valid index, or its blocks add up to more
+ * than 64 bits can count
+ */
+bool BlockCodec::readBlockOffsets(const byte* file, size_t size,
+                                  vector<BlockEntry>& blocks, Header& header,
+                                  vector<uint64_t>& outOffsets, Stats* stats) {
+    Stats::Timer timer(stats, Stats::HEADER);
+    return readIndex(file, size, blocks, header) &&
+           blockOffsets(blocks, header, outOffsets);
+}
+
+/* Finds where each block's output starts, checking every block can be decoded
+ * before any is. A block holds at most the block size and at least one bit per
+ * symbol.
+ * @param blocks Where each block is
+ * @param header Settings in the file's header
+ * @param outOffsets Set to the output offset of each block, then the total
+ * @return false if any block is too big, or the blocks add up to more than 64
+ * bits can count
+ */
+bool BlockCodec::blockOffsets(const vector<BlockEntry>& blocks,
+                              const Header& header,
+                              vector<uint64_t>& outOffsets) {
+    // each block's output starts where the blocks before it end
+    outOffsets.assign(blocks.size() + 1, 0);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].symbols > header.blockSize ||
+            blocks[i].symbols > blocks[i].bytes * BIT_IN_BYTE ||
+            blocks[i].symbols > UINT64_MAX - outOffsets[i]) {
+            return false;  // too big for its block, or the total wraps around
+        }
+        outOffsets[i + 1] = outOffsets[i] + blocks[i].symbols;
+    }
+    return true;
+}
+
+/* Runs work for every index below count on a pool of threads, this thread
+ * included. Stops handing out indices once any work fails.
+ * @param count Number of indices to run work for
+ * @param threads Number of threads to run on
+ * @param work Function run for each index, false if it failed
+ * @return false if any work failed
+ */
+bool BlockCodec::runPool(size_t count, unsigned int threads,
+                         const function<bool(size_t)>& work) {
+    atomic<size_t> next(0);
+    atomic<bool> valid(true);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count && valid; i = next++) {
+            if (!work(i)) {
+                valid = false;
+                return;
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();  // this thread works too
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return valid;
+}
+
+/* Decodes the block the entry points to, checking its headers agree with the
+ * entry.
+ * @param file First byte of the compressed file, the magic
+ * @param entry Where the block is
+ * @param out Where to write the decoded symbols, room for entry.symbols
+ * @param flags Flags of the file, saying how the block is coded
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the block does not match its entry
+ */
+bool BlockCodec::decodeIndexedBlock(const byte* file, const BlockEntry& entry,
+                                    byte* out, unsigned int flags,
+                                    Stats* stats) {
+    const byte* block = file + entry.offset;
+    BitInputStream in(block, entry.bytes);
+    uint64_t symbols = readVarint(in);
+    uint64_t payloadSize = readVarint(in);
+
+    // payload ends the block, so it starts payloadSize bytes before its end
+    if (symbols != entry.symbols || payloadSize >= entry.bytes) {
+        return false;
+    }
+    return decodeBlock(block + entry.bytes - payloadSize, payloadSize, out,
+                       symbols, flags, stats);
+}
+
+/* Decompresses only the bytes from start to start + length of the input,
+ * decoding from the closest restart point before start.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param start Offset in the input of the first byte to decompress
+ * @param length Number of bytes to decompress, fewer if the input ends
+ * @param out ostream to write the decompressed bytes to
+ * @return false if the file is not a valid compressed file with an index
+ */
+bool BlockCodec::decompressRange(const byte* file, size_t size, uint64_t start,
+                                 uint64_t length, ostream& out) {
+    vector<BlockEntry> blocks;
+    Header header;
+    if (!readIndex(file, size, blocks, header)) {
+        return false;
+    }
+
+    uint64_t end = (length > UINT64_MAX - start) ? UINT64_MAX : start + length;
+    uint64_t blockStart = 0;  // offset in the input of the current block
+    vector<byte> decoded;
+    for (const BlockEntry& entry : blocks) {
+        uint64_t blockEnd = blockStart + entry.symbols;
+        if (blockEnd <= start) {  // block is before the range
+            blockStart = blockEnd;
+            continue;
+        } else if (blockStart >= end) {
+            break;
+        }
+
+        const byte* block = file + entry.offset;
+        BitInputStream in(block, entry.bytes);
+        uint64_t symbols = readVarint(in);
+        uint64_t payloadSize = readVarint(in);
+        if (symbols != entry.symbols || payloadSize >= entry.bytes) {
+            return false;
+        }
+
+        uint64_t first = max(start, blockStart) - blockStart;
+        uint64_t last = min(end, blockEnd) - blockStart;
+        decoded.resize(last - first);
+        if (!decodeBlockRange(block + entry.bytes - payloadSize, payloadSize,
+                              entry, header, first, last, decoded.data())) {
+            return false;
+        }
+        out.write((const char*)decoded.data(), decoded.size());
+        blockStart = blockEnd;
+    }
+    return true;
+}
+
+/* Decodes the symbols from first to last of one block's payload, starting at
+ * the closest restart point before first.
+ * @param payload First byte of the payload
+ * @param payloadSize Number of bytes in the payload
+ * @param entry Where the block is, with its restart points
+ * @param header Settings in the file's header
+ * @param first Index in the block of the first symbol to decode
+ * @param last One past the index of the last symbol to decode
+ * @param out Where to write the decoded symbols
+ * @return false if a restart point is past the payload
+ */
+bool BlockCodec::decodeBlockRange(const byte* payload, size_t payloadSize,
+                                  const BlockEntry& entry, const Header& header,
+                                  uint64_t first, uint64_t last, byte* out) {
+    // no restart points, decode it all
+    if (header.flags & (FLAG_STREAMS | FLAG_CONTEXT)) {
+        vector<byte> decoded(entry.symbols);
+        if (!decodeBlock(payload, payloadSize, decoded.data(), entry.symbols,
+                         header.flags)) {
+            return false;
+        }
+        copy(decoded.begin() + first, decoded.begin() + last, out);
+        return true;
+    }
+
+    BitInputStream in(payload, payloadSize);
+    HCTree tree;
+    tree.buildWithCodeLengths(in);
+    uint64_t restartInterval = header.restartInterval;
+
+    // start at the last restart point before first, or right after the header
+    uint64_t restart = 0;
+    if (restartInterval != 0) {
+        restart = min<uint64_t>(first / restartInterval, entry.restarts.size());
+    }
+    uint64_t bit = (restart == 0) ? 0 : entry.restarts[restart - 1];
+    if (bit / BIT_IN_BYTE >= payloadSize) {
+        return false;
+    }
+    BitInputStream seek(payload + bit / BIT_IN_BYTE,
+                        payloadSize - bit / BIT_IN_BYTE);
+    seek.readBits(bit % BIT_IN_BYTE);
+    BitInputStream& from = (restart == 0) ? in : seek;
+
+    for (uint64_t i = restart * restartInterval; i < first; i++) {
+        tree.decode(from);
+    }
+    for (uint64_t i = first; i < last; i++) {
+        out[i - first] = tree.decode(from);
+    }
+    return true;
+}
+
+/* Encodes one block of data into a payload: the code length header followed
+ * by the encoded symbols, padded to a whole byte.
+ * @param data First byte of the block
+ * @param size Number of bytes in the block
+ * @param options Settings for compressing
+ * @param payload Vector to append the payload to
+ * @param restarts Vector to add the bit offset of each restart point to
+ */
+void BlockCodec::encodeBlock(const byte* data, size_t size,
+                             const Options& options, vector<byte>& payload,
+                             vector<uint64_t>& restarts) {
+    if (options.context) {
+        BitOutputStream outBit(payload);
+        encodeContexts(data, size, options, outBit);
+        outBit.flush();
+        return;
+    }
+
+    // the block's own threads, more than 1 only when blocks are not already
+    // encoded on a pool: a lone block, or blocks read from a stream
+    vector<uint64_t> freqs(ASCII_MAX);
+    {
+        Stats::Timer timer(options.stats, Stats::HISTOGRAM);
+        Histogram::countParallel(data, size, freqs, options.threads,
+                                 options.kernel);
+    }
+
+    HCTree tree;
+    {
+        Stats::Timer timer(options.stats, Stats::BUILD);
+        tree.buildCanonical(freqs, options.maxCodeLength);
+    }
+    if (options.stats != nullptr) {
+        options.stats->addBlock(freqs, tree.getCodeLengths());
+    }
+
+    BitOutputStream outBit(payload);
+    uint64_t start = outBit.getBitsWritten();
+    {
+        Stats::Timer timer(options.stats, Stats::HEADER);
+        tree.writeCodeLengths(outBit);
+    }
+    Stats::Timer timer(options.stats, Stats::CODE);
+    if (options.interleave) {
+        encodeStreams(data, size, tree, outBit);
+        outBit.flush();
+        return;
+    }
+
+    // encode a restart interval at a time, noting where each one starts
+    size_t interval = (options.restartInterval != 0) ? options.restartInterval
+                                                     : size;
+    for (size_t pos = 0; pos < size; pos += interval) {
+        if (pos != 0) {
+            restarts.push_back(outBit.getBitsWritten() - start);
+        }
+        size_t end = min(pos + interval, size);
+        for (size_t i = pos; i < end; i++) {
+            tree.encode(data[i], outBit);
+        }
+    }
+    outBit.flush();
+}
+
+/* Encodes each of the sub-streams of a block after its code length header.
+ * @param data First byte of the block
+ * @param size Number of bytes in the block
+ * @param tree HCTree with the block's code
+ * @param out BitOutputStream to write the sub-streams to
+ */
+void BlockCodec::encodeStreams(const byte* data, size_t size,
+                               const HCTree& tree, BitOutputStream& out) {
+    const size_t streams = HCTree::INTERLEAVED_STREAMS;
+    size_t part = (size + streams - 1) / streams;  // symbols per sub-stream
+
+    vector<vector<byte>> encoded(streams);
+    for (size_t i = 0; i < streams; i++) {
+        size_t first = min(i * part, size);
+        size_t last = min(first + part, size);
+        BitOutputStream streamOut(encoded[i]);
+        for (size_t j = first; j < last; j++) {
+            tree.encode(data[j], streamOut);
+        }
+        streamOut.flush();
+    }
+
+    // pad the header, then the lengths of all sub-streams but the last
+    unsigned int partial = out.getBitsWritten() % BIT_IN_BYTE;
+    if (partial != 0) {
+        out.writeBits(0, BIT_IN_BYTE - partial);
+    }
+    for (size_t i = 0; i + 1 < streams; i++) {
+        writeVarint(out, encoded[i].size());
+    }
+    for (const vector<byte>& stream : encoded) {
+        out.writeBytes(stream.data(), stream.size());
+    }
+}
+
+/* Adds the symbols of one block coded with a code per previous byte to stats,
+ * with the code lengths of each context.
+ * @param stats Where to add the symbols, nullptr for nowhere
+ * @param freqs Frequency of each symbol after each previous byte
+ * @param tree ContextHCTree with the block's codes
+ */
+static void addContextStats(Stats* stats, const vector<uint64_t>& freqs,
+                            const ContextHCTree& tree) {
+    if (stats == nullptr) {
+        return;
+    }
+    for (unsigned int context = 0; context < ContextHCTree::CONTEXTS;
+         context++) {
+        auto first = freqs.begin() + context * ASCII_MAX;
+        stats->addBlock(vector<uint64_t>(first, first + ASCII_MAX),
+                        tree.getCodeLengths(context));
+    }
+}
+
+/* Encodes one block of data with a code per previous byte: the context header
+ * followed by the encoded symbols.
+ * @param data First byte of the block
+ * @param size Number of bytes in the block
+ * @param options Settings for compressing
+ * @param out BitOutputStream to write the payload to
+ */
+void BlockCodec::encodeContexts(const byte* data, size_t size,
+                                const Options& options, BitOutputStream& out) {
+    vector<uint64_t> freqs(ASCII_MAX * ContextHCTree::CONTEXTS);
+    {
+        Stats::Timer timer(options.stats, Stats::HISTOGRAM);
+        Histogram::countContexts(data, size, freqs);
+    }
+
+    // reused by every block on this thread, only used contexts are rebuilt
+    thread_local ContextHCTree tree;
+    {
+        Stats::Timer timer(options.stats, Stats::BUILD);
+        tree.build(freqs, options.maxCodeLength);
+    }
+    addContextStats(options.stats, freqs, tree);
+    {
+        Stats::Timer timer(options.stats, Stats::HEADER);
+        tree.writeCodeLengths(out);
+    }
+
+    Stats::Timer timer(options.stats, Stats::CODE);
+    byte previous = 0;
+    for (size_t i = 0; i < size; i++) {
+        tree.encode(previous, data[i], out);
+        previous = data[i];
+    }
+}
+
+/* Decodes the payload of one block coded with a code per previous byte.
+ * @param in BitInputStream at the start of the payload
+ * @param out Where to write the decoded symbols
+ * @param symbols Number of symbols in the block
+ * @param stats Where to time phases, nullptr for none
+ */
+void BlockCodec::decodeContexts(BitInputStream& in, byte* out, size_t symbols,
+                                Stats* stats) {
+    // reused by every block on this thread, only used contexts are rebuilt
+    thread_local ContextHCTree tree;
+    {
+        Stats::Timer timer(stats, Stats::BUILD);
+        tree.buildWithCodeLengths(in);
+    }
+    {
+        Stats::Timer timer(stats, Stats::CODE);
+        byte previous = 0;
+        for (size_t i = 0; i < symbols; i++) {
+            previous = out[i] = tree.decode(previous, in);
+        }
+    }
+
+    if (stats != nullptr) {  // decoded symbols are only counted for stats
+        Stats::Timer timer(stats, Stats::HISTOGRAM);
+        vector<uint64_t> freqs(ASCII_MAX * ContextHCTree::CONTEXTS);
+        Histogram::countContexts(out, symbols, freqs);
+        addContextStats(stats, freqs, tree);
+    }
+}
+
+/* Decodes the payload of one block.
+ * @param payload First byte of the payload
+ * @param payloadSize Number of bytes in the payload
+ * @param out Where to write the decoded symbols
+ * @param symbols Number of symbols in the block
+ * @param flags Flags of the file, saying how the block is coded
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the sub-streams do not fit in the payload
+ */
+bool BlockCodec::decodeBlock(const byte* payload, size_t payloadSize,
+                             byte* out, size_t symbols, unsigned int flags,
+                             Stats* stats) {
+    BitInputStream inBit(payload, payloadSize);
+    if (flags & FLAG_CONTEXT) {
+        decodeContexts(inBit, out, symbols, stats);
+        return true;
+    }
+
+    HCTree tree;
+    {
+        Stats::Timer timer(stats, Stats::BUILD);
+        tree.buildWithCodeLengths(inBit);
+        if (!(flags & FLAG_STREAMS)) {
+            tree.buildMultiDecodeTable();
+        }
+    }
+    {
+        Stats::Timer timer(stats, Stats::CODE);
+        if (flags & FLAG_STREAMS) {
+            if (!decodeStreams(inBit, payload + payloadSize, tree, out,
+                               symbols)) {
+                return false;
+            }
+        } else {
+            tree.decodeMany(inBit, out, symbols);
+        }
+    }
+
+    if (stats != nullptr) {  // decoded symbols are only counted for stats
+        Stats::Timer timer(stats, Stats::HISTOGRAM);
+        vector<uint64_t> freqs(ASCII_MAX);
+        Histogram::count(out, symbols, freqs);
+        stats->addBlock(freqs, tree.getCodeLengths());
+    }
+    return true;
+}
+
+/* Decodes the sub-streams of a block after its code length header.
+ * @param in BitInputStream right after the code length header
+ * @param end One past the last byte of the payload
+ * @param tree HCTree with the block's code
+ * @param out Where to write the decoded symbols
+ * @param symbols Number of symbols in the block
+ * @return false if the sub-streams do not fit in the payload
+ */
+bool BlockCodec::decodeStreams(BitInputStream& in, const byte* end,
+                               const HCTree& tree, byte* out, size_t symbols) {
+    const size_t streams = HCTree::INTERLEAVED_STREAMS;
+    size_t part = (symbols + streams - 1) / streams;  // symbols per sub-stream
+
+    // sub-streams lie one after another, the last one up to the end
+    in.skipToByte();
+    vector<uint64_t> lengths(streams);
+    for (size_t i = 0; i + 1 < streams; i++) {
+        lengths[i] = readVarint(in);
+    }
+    size_t left = in.bytesLeft();
+    const byte* next = end - left;
+
+    vector<BitInputStream> inputs;
+    vector<byte*> outputs;
+    size_t common = part;  // symbols every sub-stream has
+    for (size_t i = 0; i < streams; i++) {
+        if (i + 1 == streams) {
+            lengths[i] = left;
+        } else if (lengths[i] > left) {
+            return false;
+        }
+        inputs.emplace_back(next, lengths[i]);
+        next += lengths[i];
+        left -= lengths[i];
+
+        size_t first = min(i * part, symbols);
+        outputs.push_back(out + first);
+        common = min(common, min(first + part, symbols) - first);
+    }
+
+    // all sub-streams at once, then what is left of the longer ones alone
+    tree.decodeInterleaved(inputs.data(), outputs.data(), common);
+    for (size_t i = 0; i < streams; i++) {
+        size_t first = min(i * part, symbols);
+        size_t last = min(first + part, symbols);
+        for (size_t j = first + common; j < last; j++) {
+            out[j] = tree.decode(inputs[i]);
+        }
+    }
+    return true;
+}
+
+/* Reads the flags, block size and restart interval of a compressed file.
+ * @param in BitInputStream positioned right after the version
+ * @param header Set to the settings read
+ * @return false if the header is not valid, or its blocks are bigger than
+ * MAX_BLOCK_SIZE
+ */
+bool BlockCodec::readHeader(BitInputStream& in, Header& header) {
+    header.flags = in.readBits(FLAGS_BITS);
+    header.blockSize = readVarint(in);
+    if (header.blockSize > MAX_BLOCK_SIZE) {
+        return false;  // no block could be held in memory to decode
+    }
+    header.restartInterval = 0;
+    if (header.flags & FLAG_RESTARTS) {
+        header.restartInterval = readVarint(in);
+        if (header.restartInterval == 0 ||
+            (header.flags & (FLAG_STREAMS | FLAG_CONTEXT))) {
+            return false;  // sub-streams and contexts have no restart points
+        }
+    }
+    if ((header.flags & FLAG_STREAMS) && (header.flags & FLAG_CONTEXT)) {
+        return false;  // contexts are not split in sub-streams
+    }
+    return true;
+}
+
+/* Reads the index at the end of a compressed file.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param blocks Vector to store where each block is
+ * @return false if the file has no valid index
+ */
+bool BlockCodec::readIndex(const byte* file, size_t size,
+                           vector<BlockEntry>& blocks) {
+    Header header;
+    return readIndex(file, size, blocks, header);
+}
+
+/* Reads the index at the end of a compressed file, with its restart points.
+ * @param file First byte of the compressed file, the magic
+ * @param size Number of bytes in the compressed file
+ * @param blocks Vector to store where each block is
+ * @param header Set to the settings in the file's header
+ * @return false if the file has no valid index
+ */
+bool BlockCodec::readIndex(const byte* file, size_t size,
+                           vector<BlockEntry>& blocks, Header& header) {
+    const size_t trailerSize = INDEX_OFFSET_BITS / BIT_IN_BYTE;
+    const size_t headerSize = (MAGIC_BITS + VERSION_BITS + FLAGS_BITS) /
+                              BIT_IN_BYTE;
+    if (size < headerSize + trailerSize) {
+        return false;
+    }
+
+    BitInputStream in(file, size - trailerSize);
+    if (in.readBits(MAGIC_BITS) != MAGIC ||
+        in.readBits(VERSION_BITS) != VERSION || !readHeader(in, header) ||
+        (header.flags & FLAG_INDEX) == 0) {
+        return false;
+    }
+    uint64_t headerEnd = size - trailerSize - in.bytesLeft();
+    uint64_t restartInterval = header.restartInterval;
+
+    BitInputStream trailer(file + size - trailerSize, trailerSize);
+    uint64_t indexOffset = trailer.readBits(INDEX_OFFSET_BITS);
+    if (indexOffset >= size - trailerSize) {
+        return false;
+    }
+
+    // entries must describe blocks lying one after another before the index
+    BitInputStream index(file + indexOffset, size - trailerSize - indexOffset);
+    uint64_t count = readVarint(index);
+    uint64_t offset = readVarint(index);
+    if (count > indexOffset ||  // every block takes more than a byte
+        offset < headerEnd || offset > indexOffset) {
+        return false;
+    }
+    blocks.clear();
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t bytes = readVarint(index);
+        uint64_t symbols = readVarint(index);
+        if (bytes > indexOffset - offset) {  // offset stays before the index
+            return false;
+        }
+        blocks.push_back(BlockEntry{offset, bytes, symbols, {}});
+        offset += bytes;
+
+        if (restartInterval == 0 || symbols == 0) {
+            continue;
+        }
+        // every symbol takes a bit, so restart points lie within the block
+        uint64_t restarts = (symbols - 1) / restartInterval;
+        if (restarts > bytes * BIT_IN_BYTE) {
+            return false;
+        }
+        uint64_t restart = 0;
+        for (uint64_t j = 0; j < restarts; j++) {
+            restart += readVarint(index);
+            if (restart > bytes * BIT_IN_BYTE) {
+                return false;
+            }
+            blocks.back().restarts.push_back(restart);
+        }
+    }
+    return true;
+}
+
+/* Writes an unsigned integer in as few bytes as it takes, 7 bits per byte
+ * starting from the least significant bits.
+ * @param out BitOutputStream to write to
+ * @param value Integer to write
+ */
+void BlockCodec::writeVarint(BitOutputStream& out, uint64_t value) {
+    while (value >= VARINT_MORE) {
+        out.writeBits((value & (VARINT_MORE - 1)) | VARINT_MORE, BIT_IN_BYTE);
+        value >>= VARINT_DATA_BITS;
+    }
+    out.writeBits(value, BIT_IN_BYTE);
+}
+
+/* Reads an unsigned integer written by writeVarint.
+ * @param in BitInputStream to read from
+ * @return integer read
+ */
+uint64_t BlockCodec::readVarint(BitInputStream& in) {
+    uint64_t value = 0;
+    for (int i = 0; i < VARINT_MAX_BYTES; i++) {
+        uint64_t part = in.readBits(BIT_IN_BYTE);
+        value |= (part & (VARINT_MORE - 1)) << (i * VARINT_DATA_BITS);
+        if ((part & VARINT_MORE) == 0) {
+            break;
+        }
+    }
+    return value;
+}
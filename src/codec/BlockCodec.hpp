@@ -0,0 +1,430 @@
+/**
+ * Block container format for Huffman compressed files. The input is split into
+ * fixed size blocks and each block is compressed on its own with its own
+ * canonical code, so blocks adapt to the data they hold and can be handled
+ * independently of each other.
+ *
+ * A compressed file starts with the 32 bit magic, an 8 bit version and 8 bits
+ * of flags, followed by the block size. Each block then holds its number of
+ * symbols, the number of bytes of its payload and the payload itself: the
+ * code length header followed by the encoded symbols, padded to a whole byte.
+ * A block with 0 symbols ends the blocks. Sizes are stored as variable length
+ * integers, 7 bits per byte with the high bit set on all but the last byte.
+ * If the restarts flag is set, the block size is followed by the restart
+ * interval.
+ *
+ * If the streams flag is set, the symbols of each block are split into four
+ * equal parts, the last one shorter, each encoded as its own sub-stream with
+ * the block's code. The payload then holds the code length header padded to a
+ * whole byte, the byte lengths of the first three sub-streams, then the four
+ * sub-streams each padded to a whole byte, so all four can be decoded at once.
+ * Such files have no restart points.
+ *
+ * If the context flag is set, the symbols of each block are coded with one
+ * code per value of the byte before them, the first symbol of the block
+ * following a 0. The payload's header then holds one bit per previous byte,
+ * each set bit followed by the code lengths of that context. Such files have
+ * no restart points or sub-streams either.
+ *
+ * If the index flag is set, an index follows the end block so blocks can be
+ * found without reading the ones before them. It holds the number of blocks,
+ * the offset of the first block, then the total bytes and symbols of each
+ * block. With the restarts flag, each block's entry goes on with a restart
+ * point for every restart interval symbols after the first: the bit offset in
+ * the payload where that symbol's code starts, stored as the distance from the
+ * previous restart point. Decoding can start at any restart point using the
+ * block's code, so a range of the input is found without decoding its whole
+ * block. The file ends with the offset of the index as a 64 bit integer. All
+ * other offsets are in bytes from the start of the magic.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef BLOCKCODEC_HPP
+#define BLOCKCODEC_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "HCTree.hpp"
+#include "Histogram.hpp"
+#include "Stats.hpp"
+
+using namespace std;
+
+/** Class for BlockCodec that reads and writes the block container format.
+ *  Compresses a whole input into blocks and decompresses blocks back.
+ */
+class BlockCodec {
+  public:
+    static const uint32_t MAGIC = 0xFF48435A;  // "\xFFHCZ", starts the file
+    static const unsigned int MAGIC_BITS = 32;    // bits of the magic
+    static const unsigned int VERSION = 2;        // version of block container
+    static const unsigned int VERSION_BITS = 8;   // bits of the version
+    static const unsigned int FLAGS_BITS = 8;     // bits of the flags
+    static const unsigned int FLAG_INDEX = 1;     // flag set if file has index
+    static const unsigned int FLAG_RESTARTS = 2;  // flag set if index has
+                                                  // restart points
+    static const unsigned int FLAG_STREAMS = 4;   // flag set if blocks are
+                                                  // interleaved sub-streams
+    static const unsigned int FLAG_CONTEXT = 8;   // flag set if blocks have a
+                                                  // code per previous byte
+    static const unsigned int INDEX_OFFSET_BITS = 64;  // bits of index offset
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;  // bytes per block
+    static const size_t MAX_BLOCK_SIZE = 1 << 30;      // most bytes per block
+    static const size_t DEFAULT_RESTART_INTERVAL = 1 << 16;  // symbols per
+                                                             // restart point
+
+    /* Where to find one block of a compressed file */
+    struct BlockEntry {
+        uint64_t offset;  // byte where the block starts, counting from magic
+        uint64_t bytes;   // number of bytes in the block, headers included
+        uint64_t symbols;  // number of symbols the block decodes to
+        vector<uint64_t> restarts;  // bit offsets in payload of restart points
+    };
+
+    /* Settings read from the header of a compressed file */
+    struct Header {
+        unsigned int flags;        // flags set for the file
+        uint64_t blockSize;        // most symbols in a block
+        uint64_t restartInterval;  // symbols per restart point, 0 for none
+    };
+
+    /* Settings for compressing */
+    struct Options {
+        size_t blockSize;            // bytes of input per block
+        unsigned int maxCodeLength;  // longest code allowed, 0 for no limit
+        size_t restartInterval;      // symbols per restart point, 0 for none
+        bool interleave;             // whether to split blocks in sub-streams
+        bool context;                // whether to code after previous byte
+        unsigned int threads;        // threads to compress blocks with
+        Histogram::Kernel kernel;    // way of counting frequencies
+        Stats* stats;                // where to time phases, nullptr for none
+
+        /* Constructor of Options with the default settings. */
+        Options()
+            : blockSize(DEFAULT_BLOCK_SIZE),
+              maxCodeLength(0),
+              restartInterval(DEFAULT_RESTART_INTERVAL),
+              interleave(false),
+              context(false),
+              threads(1),
+              kernel(Histogram::INTERLEAVED),
+              stats(nullptr) {}
+    };
+
+    /* Compresses all of data, from the magic to the index. With more than
+     * one thread, blocks are encoded by a pool of worker threads and written
+     * out in order as they finish.
+     * @param data First byte to compress
+     * @param size Number of bytes to compress
+     * @param out BitOutputStream to write the compressed file to
+     * @param options Settings for compressing
+     */
+    static void compress(const byte* data, size_t size, BitOutputStream& out,
+                         const Options& options);
+
+    /* Compresses everything left in an input stream, one block at a time.
+     * Only one block of input is held in memory, and each block is written
+     * out and flushed before the next one is read.
+     * @param in istream to read the input from
+     * @param out BitOutputStream to write the compressed file to
+     * @param options Settings for compressing
+     */
+    static void compress(istream& in, BitOutputStream& out,
+                         const Options& options);
+
+    /* Decompresses a file whose magic and version have already been read.
+     * @param in BitInputStream positioned right after the version
+     * @param out ostream to write the decompressed bytes to
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the file is not a valid compressed file
+     */
+    static bool decompress(BitInputStream& in, ostream& out,
+                           Stats* stats = nullptr);
+
+    /* Decompresses a whole compressed file from its already read index.
+     * Blocks are decoded by a pool of worker threads, each block written
+     * straight to its place in the output file. Every block is checked before
+     * the pool starts.
+     * @param file First byte of the compressed file, the magic
+     * @param blocks Where each block is, as read by readIndex
+     * @param header Settings in the file's header, as read by readIndex
+     * @param fd File descriptor of the output file, opened for writing
+     * @param threads Number of threads to decode with
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the blocks are not valid or could not be written
+     */
+    static bool decompressParallel(const byte* file,
+                                   const vector<BlockEntry>& blocks,
+                                   const Header& header, int fd,
+                                   unsigned int threads,
+                                   Stats* stats = nullptr);
+
+    /* Decompresses a whole compressed file that has an index into memory.
+     * Blocks are decoded by a pool of worker threads, each block straight
+     * into its place in out.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param out Where to write the decompressed bytes
+     * @param capacity Number of bytes out has room for
+     * @param threads Number of threads to decode with
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the file is not a valid compressed file with an index,
+     * or it decompresses to more than capacity bytes
+     */
+    static bool decompress(const byte* file, size_t size, byte* out,
+                           size_t capacity, unsigned int threads = 1,
+                           Stats* stats = nullptr);
+
+    /* Returns how many bytes a compressed file with an index decompresses to.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param symbols Set to the number of decompressed bytes
+     * @return false if the file is not a valid compressed file with an index
+     */
+    static bool decompressedSize(const byte* file, size_t size,
+                                 uint64_t& symbols);
+
+    /* Decompresses only the bytes from start to start + length of the
+     * input, decoding from the closest restart point before start.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param start Offset in the input of the first byte to decompress
+     * @param length Number of bytes to decompress, fewer if the input ends
+     * @param out ostream to write the decompressed bytes to
+     * @return false if the file is not a valid compressed file with an index
+     */
+    static bool decompressRange(const byte* file, size_t size, uint64_t start,
+                                uint64_t length, ostream& out);
+
+    /* Encodes one block of data into a payload: the code length header
+     * followed by the encoded symbols, padded to a whole byte.
+     * @param data First byte of the block
+     * @param size Number of bytes in the block
+     * @param options Settings for compressing
+     * @param payload Vector to append the payload to
+     * @param restarts Vector to add the bit offset of each restart point to
+     */
+    static void encodeBlock(const byte* data, size_t size,
+                            const Options& options, vector<byte>& payload,
+                            vector<uint64_t>& restarts);
+
+    /* Decodes the payload of one block.
+     * @param payload First byte of the payload
+     * @param payloadSize Number of bytes in the payload
+     * @param out Where to write the decoded symbols
+     * @param symbols Number of symbols in the block
+     * @param flags Flags of the file, saying how the block is coded
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the sub-streams do not fit in the payload
+     */
+    static bool decodeBlock(const byte* payload, size_t payloadSize, byte* out,
+                            size_t symbols, unsigned int flags = 0,
+                            Stats* stats = nullptr);
+
+    /* Reads the flags, block size and restart interval of a compressed file.
+     * @param in BitInputStream positioned right after the version
+     * @param header Set to the settings read
+     * @return false if the header is not valid, or its blocks are bigger than
+     * MAX_BLOCK_SIZE
+     */
+    static bool readHeader(BitInputStream& in, Header& header);
+
+    /* Reads the index at the end of a compressed file.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param blocks Vector to store where each block is
+     * @return false if the file has no valid index
+     */
+    static bool readIndex(const byte* file, size_t size,
+                          vector<BlockEntry>& blocks);
+
+    /* Reads the index at the end of a compressed file, with its restart
+     * points.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param blocks Vector to store where each block is
+     * @param header Set to the settings in the file's header
+     * @return false if the file has no valid index
+     */
+    static bool readIndex(const byte* file, size_t size,
+                          vector<BlockEntry>& blocks, Header& header);
+
+    /* Writes an unsigned integer in as few bytes as it takes, 7 bits per byte
+     * starting from the least significant bits.
+     * @param out BitOutputStream to write to
+     * @param value Integer to write
+     */
+    static void writeVarint(BitOutputStream& out, uint64_t value);
+
+    /* Reads an unsigned integer written by writeVarint.
+     * @param in BitInputStream to read from
+     * @return integer read
+     */
+    static uint64_t readVarint(BitInputStream& in);
+
+  private:
+    /* Writes the magic, version, flags, block size and restart interval.
+     * @param out BitOutputStream to write to
+     * @param options Settings for compressing
+     */
+    static void writeHeader(BitOutputStream& out, const Options& options);
+
+    /* Writes the end block, the index and where the index starts.
+     * @param out BitOutputStream to write to
+     * @param start Bytes written to out before the magic
+     * @param firstBlockOffset Offset of the first block from the magic
+     * @param index Entries of every block written
+     */
+    static void writeIndex(BitOutputStream& out, uint64_t start,
+                           uint64_t firstBlockOffset,
+                           const vector<BlockEntry>& index);
+
+    /* Decodes the block the entry points to, checking its headers agree with
+     * the entry.
+     * @param file First byte of the compressed file, the magic
+     * @param entry Where the block is
+     * @param out Where to write the decoded symbols, room for entry.symbols
+     * @param flags Flags of the file, saying how the block is coded
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the block does not match its entry
+     */
+    static bool decodeIndexedBlock(const byte* file, const BlockEntry& entry,
+                                   byte* out, unsigned int flags,
+                                   Stats* stats);
+
+    /* Encodes each of the sub-streams of a block after its code length
+     * header.
+     * @param data First byte of the block
+     * @param size Number of bytes in the block
+     * @param tree HCTree with the block's code
+     * @param out BitOutputStream to write the sub-streams to
+     */
+    static void encodeStreams(const byte* data, size_t size,
+                              const HCTree& tree, BitOutputStream& out);
+
+    /* Encodes one block of data with a code per previous byte: the context
+     * header followed by the encoded symbols.
+     * @param data First byte of the block
+     * @param size Number of bytes in the block
+     * @param options Settings for compressing
+     * @param out BitOutputStream to write the payload to
+     */
+    static void encodeContexts(const byte* data, size_t size,
+                               const Options& options, BitOutputStream& out);
+
+    /* Decodes the payload of one block coded with a code per previous byte.
+     * @param in BitInputStream at the start of the payload
+     * @param out Where to write the decoded symbols
+     * @param symbols Number of symbols in the block
+     * @param stats Where to time phases, nullptr for none
+     */
+    static void decodeContexts(BitInputStream& in, byte* out, size_t symbols,
+                               Stats* stats);
+
+    /* Decodes the sub-streams of a block after its code length header.
+     * @param in BitInputStream right after the code length header
+     * @param end One past the last byte of the payload
+     * @param tree HCTree with the block's code
+     * @param out Where to write the decoded symbols
+     * @param symbols Number of symbols in the block
+     * @return false if the sub-streams do not fit in the payload
+     */
+    static bool decodeStreams(BitInputStream& in, const byte* end,
+                              const HCTree& tree, byte* out, size_t symbols);
+
+    /* Decodes the symbols from first to last of one block's payload,
+     * starting at the closest restart point before first.
+     * @param payload First byte of the payload
+     * @param payloadSize Number of bytes in the payload
+     * @param entry Where the block is, with its restart points
+     * @param header Settings in the file's header
+     * @param first Index in the block of the first symbol to decode
+     * @param last One past the index of the last symbol to decode
+     * @param out Where to write the decoded symbols
+     * @return false if a restart point is past the payload
+     */
+    static bool decodeBlockRange(const byte* payload, size_t payloadSize,
+                                 const BlockEntry& entry, const Header& header,
+                                 uint64_t first, uint64_t last, byte* out);
+
+    /* Writes one block and records where it went in the index.
+     * @param out BitOutputStream to write to
+     * @param symbols Number of symbols in the block
+     * @param payload Payload of the block
+     * @param restarts Bit offsets of the block's restart points
+     * @param start Bytes written to out before the magic
+     * @param index Vector to add the block's entry to
+     */
+    static void writeBlock(BitOutputStream& out, uint64_t symbols,
+                           const vector<byte>& payload,
+                           const vector<uint64_t>& restarts, uint64_t start,
+                           vector<BlockEntry>& index);
+
+    /* Encodes every block on a pool of worker threads and writes them out in
+     * order. Only a few blocks more than there are threads are held in memory
+     * at a time.
+     * @param data First byte to compress
+     * @param size Number of bytes to compress
+     * @param out BitOutputStream to write the blocks to
+     * @param options Settings for compressing
+     * @param start Bytes written to out before the magic
+     * @param index Vector to add the blocks' entries to
+     */
+    static void compressParallel(const byte* data, size_t size,
+                                 BitOutputStream& out, const Options& options,
+                                 uint64_t start, vector<BlockEntry>& index);
+
+    /* Reads the index of a compressed file and where each block's output
+     * starts.
+     * @param file First byte of the compressed file, the magic
+     * @param size Number of bytes in the compressed file
+     * @param blocks Vector to store where each block is
+     * @param header Set to the settings in the file's header
+     * @param outOffsets Set to the output offset of each block, then the total
+     * @param stats Where to time phases, nullptr for none
+     * @return false if the file has no valid index, or its blocks add up to
+     * more than 64 bits can count
+     */
+    static bool readBlockOffsets(const byte* file, size_t size,
+                                 vector<BlockEntry>& blocks, Header& header,
+                                 vector<uint64_t>& outOffsets,
+                                 Stats* stats = nullptr);
+
+    /* Returns the most bytes a block's payload can take: the longest header,
+     * every symbol coded with the longest code, and padding.
+     * @param symbols Number of symbols in the block
+     * @param flags Flags of the file, saying how the block is coded
+     * @return most bytes of the payload
+     */
+    static uint64_t maxPayloadSize(uint64_t symbols, unsigned int flags);
+
+    /* Finds where each block's output starts, checking every block can be
+     * decoded before any is. A block holds at most the block size and at least
+     * one bit per symbol.
+     * @param blocks Where each block is
+     * @param header Settings in the file's header
+     * @param outOffsets Set to the output offset of each block, then the total
+     * @return false if any block is too big, or the blocks add up to more than
+     * 64 bits can count
+     */
+    static bool blockOffsets(const vector<BlockEntry>& blocks,
+                             const Header& header,
+                             vector<uint64_t>& outOffsets);
+
+    /* Runs work for every index below count on a pool of threads, this thread
+     * included. Stops handing out indices once any work fails.
+     * @param count Number of indices to run work for
+     * @param threads Number of threads to run on
+     * @param work Function run for each index, false if it failed
+     * @return false if any work failed
+     */
+    static bool runPool(size_t count, unsigned int threads,
+                        const function<bool(size_t)>& work);
+};
+
+#endif  // BLOCKCODEC_HPP
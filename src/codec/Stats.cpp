@@ -0,0 +1,218 @@
+/**
+ * Report of where the time of compressing or decompressing goes.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "Stats.hpp"
+
+#include <time.h>
+#include <cmath>
+#include <iomanip>
+
+#define ASCII_MAX 256       // number of symbols counted
+#define BIT_IN_BYTE 8       // bits of a compressed byte
+#define MS_PER_SECOND 1000  // times are reported in milliseconds
+#define BYTES_PER_MB 1e6    // throughput is reported in MB/s
+#define NAME_WIDTH 12       // width of the phase column of the table
+#define TIME_WIDTH 12       // width of the time columns of the table
+
+const char* const Stats::PHASE_NAMES[PHASES] = {
+    "probe", "histogram", "build", "header", "code", "flush"};
+
+/* Returns the CPU time used so far by the given clock.
+ * @param clock CLOCK_THREAD_CPUTIME_ID or CLOCK_PROCESS_CPUTIME_ID
+ * @return CPU time in seconds
+ */
+static double cpuSeconds(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Returns the wall time since the given time.
+ * @param start Time to measure from
+ * @return wall time in seconds
+ */
+static double wallSecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+        .count();
+}
+
+/* Constructor of Timer. Starts timing.
+ * @param stats Stats to add the time to, nullptr to not time
+ * @param phase Phase being timed
+ */
+Stats::Timer::Timer(Stats* stats, Phase phase)
+    : stats(stats), phase(phase), cpuStart(0) {
+    if (stats != nullptr) {
+        wallStart = chrono::steady_clock::now();
+        cpuStart = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+    }
+}
+
+/* Deconstructor.
+ * Adds the time since construction to the phase, unless stopped. */
+Stats::Timer::~Timer() { stop(); }
+
+/* Adds the time since construction to the phase and stops timing. */
+void Stats::Timer::stop() {
+    if (stats != nullptr) {
+        stats->addTime(phase, wallSecondsSince(wallStart),
+                       cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - cpuStart);
+        stats = nullptr;
+    }
+}
+
+/* Constructor of Stats.
+ * Starts the total time. */
+Stats::Stats()
+    : wallTimes(),
+      cpuTimes(),
+      freqs(ASCII_MAX),
+      codeBits(0),
+      symbols(0),
+      compressed(0),
+      wallStart(chrono::steady_clock::now()),
+      cpuStart(cpuSeconds(CLOCK_PROCESS_CPUTIME_ID)),
+      wallTotal(0),
+      cpuTotal(0) {}
+
+/* Adds time to a phase.
+ * @param phase Phase to add to
+ * @param wall Wall time in seconds
+ * @param cpu CPU time in seconds
+ */
+void Stats::addTime(Phase phase, double wall, double cpu) {
+    lock_guard<mutex> guard(lock);
+    wallTimes[phase] += wall;
+    cpuTimes[phase] += cpu;
+}
+
+/* Adds the symbols of one block and the lengths of their codes.
+ * @param blockFreqs Frequency of each symbol in the block
+ * @param codeLengths Length of the code of each symbol
+ */
+void Stats::addBlock(const vector<uint64_t>& blockFreqs,
+                     const vector<byte>& codeLengths) {
+    lock_guard<mutex> guard(lock);
+    for (unsigned int i = 0; i < ASCII_MAX && i < blockFreqs.size(); i++) {
+        freqs[i] += blockFreqs[i];
+        symbols += blockFreqs[i];
+        if (i < codeLengths.size()) {
+            codeBits += blockFreqs[i] * codeLengths[i];
+        }
+    }
+}
+
+/* Adds the symbols of one chunk and the bits their codes took, for codes that
+ * change from one symbol to the next.
+ * @param chunkFreqs Frequency of each symbol in the chunk
+ * @param bits Bits taken by the codes of the chunk's symbols
+ */
+void Stats::addCoded(const vector<uint64_t>& chunkFreqs, uint64_t bits) {
+    lock_guard<mutex> guard(lock);
+    for (unsigned int i = 0; i < ASCII_MAX && i < chunkFreqs.size(); i++) {
+        freqs[i] += chunkFreqs[i];
+        symbols += chunkFreqs[i];
+    }
+    codeBits += bits;
+}
+
+/* Stops the total time and records the size of the compressed file.
+ * @param compressedBytes Bytes of the compressed file
+ */
+void Stats::finish(uint64_t compressedBytes) {
+    wallTotal = wallSecondsSince(wallStart);
+    cpuTotal = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+    compressed = compressedBytes;
+}
+
+/* Returns the Shannon entropy of all symbols added.
+ * @return bits of information per symbol
+ */
+double Stats::entropy() const {
+    double bits = 0;
+    for (uint64_t freq : freqs) {
+        if (freq != 0) {
+            double p = (double)freq / symbols;
+            bits -= p * log2(p);
+        }
+    }
+    return bits;
+}
+
+/* Returns the average length of the codes of all symbols added.
+ * @return bits per symbol
+ */
+double Stats::averageCodeLength() const {
+    return (symbols == 0) ? 0 : (double)codeBits / symbols;
+}
+
+/* Returns how many bytes of the compressed file do not hold codes: the
+ * container header, code length headers, block sizes, padding and index.
+ * @return bytes of headers
+ */
+uint64_t Stats::headerBytes() const {
+    uint64_t codeBytes = (codeBits + BIT_IN_BYTE - 1) / BIT_IN_BYTE;
+    return (compressed > codeBytes) ? compressed - codeBytes : 0;
+}
+
+/* Returns how fast bytes went through.
+ * @param bytes Number of bytes
+ * @return millions of bytes per second of total wall time
+ */
+double Stats::megabytesPerSecond(uint64_t bytes) const {
+    return (wallTotal <= 0) ? 0 : bytes / BYTES_PER_MB / wallTotal;
+}
+
+/* Writes the report as a table.
+ * @param out ostream to write to
+ */
+void Stats::print(ostream& out) const {
+    out << fixed << setprecision(3);
+    out << left << setw(NAME_WIDTH) << "phase" << right << setw(TIME_WIDTH)
+        << "wall ms" << setw(TIME_WIDTH) << "cpu ms" << "\n";
+    for (unsigned int i = 0; i < PHASES; i++) {
+        out << left << setw(NAME_WIDTH) << PHASE_NAMES[i] << right
+            << setw(TIME_WIDTH) << wallTimes[i] * MS_PER_SECOND
+            << setw(TIME_WIDTH) << cpuTimes[i] * MS_PER_SECOND << "\n";
+    }
+    out << left << setw(NAME_WIDTH) << "total" << right << setw(TIME_WIDTH)
+        << wallTotal * MS_PER_SECOND << setw(TIME_WIDTH)
+        << cpuTotal * MS_PER_SECOND << "\n";
+
+    out << "uncompressed bytes: " << symbols << " ("
+        << megabytesPerSecond(symbols) << " MB/s)\n";
+    out << "compressed bytes: " << compressed << " ("
+        << megabytesPerSecond(compressed) << " MB/s)\n";
+    out << "entropy: " << entropy() << " bits/symbol\n";
+    out << "average code length: " << averageCodeLength() << " bits/symbol\n";
+    out << "header bytes: " << headerBytes() << "\n";
+    out << defaultfloat;
+}
+
+/* Writes the report as a JSON object.
+ * @param out ostream to write to
+ */
+void Stats::writeJson(ostream& out) const {
+    out << setprecision(6) << "{\n  \"phases\": {\n";
+    for (unsigned int i = 0; i < PHASES; i++) {
+        out << "    \"" << PHASE_NAMES[i] << "\": {\"wall_ms\": "
+            << wallTimes[i] * MS_PER_SECOND
+            << ", \"cpu_ms\": " << cpuTimes[i] * MS_PER_SECOND << "}"
+            << (i + 1 < PHASES ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    out << "  \"total\": {\"wall_ms\": " << wallTotal * MS_PER_SECOND
+        << ", \"cpu_ms\": " << cpuTotal * MS_PER_SECOND << "},\n";
+    out << "  \"uncompressed_bytes\": " << symbols << ",\n";
+    out << "  \"compressed_bytes\": " << compressed << ",\n";
+    out << "  \"uncompressed_mb_per_s\": " << megabytesPerSecond(symbols)
+        << ",\n";
+    out << "  \"compressed_mb_per_s\": " << megabytesPerSecond(compressed)
+        << ",\n";
+    out << "  \"entropy_bits_per_symbol\": " << entropy() << ",\n";
+    out << "  \"average_code_length_bits\": " << averageCodeLength() << ",\n";
+    out << "  \"header_bytes\": " << headerBytes() << "\n}\n";
+}
@@ -0,0 +1,145 @@
+/**
+ * Report of where the time of compressing or decompressing goes. Keeps the
+ * wall and CPU time of each phase, the histogram of the uncompressed data and
+ * how many bits its codes took, and prints them as a table or as JSON.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Class for Stats that collects phase times and sizes while compressing or
+ *  decompressing. Blocks coded on several threads can add to the same Stats,
+ *  in which case phase times are summed over the threads.
+ */
+class Stats {
+  public:
+    /* Phases of compressing or decompressing */
+    enum Phase {
+        PROBE,      // opening the files and reading the container header
+        HISTOGRAM,  // counting symbols
+        BUILD,      // building codes
+        HEADER,     // writing or reading code length headers and the index
+        CODE,       // encoding or decoding symbols
+        FLUSH,      // writing out what is left
+        PHASES      // number of phases
+    };
+
+    /** Class for Timer that adds the time from its construction to its
+     *  destruction to one phase. Does nothing without a Stats.
+     */
+    class Timer {
+      private:
+        Stats* stats;  // where to add the time, nullptr for nowhere
+        Phase phase;   // phase being timed
+        chrono::steady_clock::time_point wallStart;  // wall time at start
+        double cpuStart;  // CPU time of the thread at start, in seconds
+
+      public:
+        /* Constructor of Timer. Starts timing.
+         * @param stats Stats to add the time to, nullptr to not time
+         * @param phase Phase being timed
+         */
+        Timer(Stats* stats, Phase phase);
+
+        /* Deconstructor.
+         * Adds the time since construction to the phase, unless stopped. */
+        ~Timer();
+
+        /* Adds the time since construction to the phase and stops timing. */
+        void stop();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+    };
+
+    /* Constructor of Stats.
+     * Starts the total time. */
+    Stats();
+
+    /* Adds time to a phase.
+     * @param phase Phase to add to
+     * @param wall Wall time in seconds
+     * @param cpu CPU time in seconds
+     */
+    void addTime(Phase phase, double wall, double cpu);
+
+    /* Adds the symbols of one block and the lengths of their codes.
+     * @param blockFreqs Frequency of each symbol in the block
+     * @param codeLengths Length of the code of each symbol
+     */
+    void addBlock(const vector<uint64_t>& blockFreqs,
+                  const vector<byte>& codeLengths);
+
+    /* Adds the symbols of one chunk and the bits their codes took, for codes
+     * that change from one symbol to the next.
+     * @param chunkFreqs Frequency of each symbol in the chunk
+     * @param bits Bits taken by the codes of the chunk's symbols
+     */
+    void addCoded(const vector<uint64_t>& chunkFreqs, uint64_t bits);
+
+    /* Stops the total time and records the size of the compressed file.
+     * @param compressedBytes Bytes of the compressed file
+     */
+    void finish(uint64_t compressedBytes);
+
+    /* Returns the Shannon entropy of all symbols added.
+     * @return bits of information per symbol
+     */
+    double entropy() const;
+
+    /* Returns the average length of the codes of all symbols added.
+     * @return bits per symbol
+     */
+    double averageCodeLength() const;
+
+    /* Writes the report as a table.
+     * @param out ostream to write to
+     */
+    void print(ostream& out) const;
+
+    /* Writes the report as a JSON object.
+     * @param out ostream to write to
+     */
+    void writeJson(ostream& out) const;
+
+  private:
+    static const char* const PHASE_NAMES[PHASES];  // names used in reports
+
+    double wallTimes[PHASES];  // wall time of each phase, in seconds
+    double cpuTimes[PHASES];   // CPU time of each phase, in seconds
+    vector<uint64_t> freqs;    // frequency of each symbol over all blocks
+    uint64_t codeBits;         // bits taken by the codes of all symbols
+    uint64_t symbols;          // number of symbols, the uncompressed bytes
+    uint64_t compressed;       // bytes of the compressed file
+    chrono::steady_clock::time_point wallStart;  // wall time at construction
+    double cpuStart;   // CPU time of the process at construction
+    double wallTotal;  // wall time from construction to finish
+    double cpuTotal;   // CPU time of the process from construction to finish
+    mutex lock;        // held while adding from several threads
+
+    /* Returns how many bytes of the compressed file do not hold codes: the
+     * container header, code length headers, block sizes, padding and index.
+     * @return bytes of headers
+     */
+    uint64_t headerBytes() const;
+
+    /* Returns how fast bytes went through.
+     * @param bytes Number of bytes
+     * @return millions of bytes per second of total wall time
+     */
+    double megabytesPerSecond(uint64_t bytes) const;
+};
+
+#endif  // STATS_HPP
@@ -5,20 +5,21 @@
  * Author: Aimee T Shao
  * PID: A15444996
  */
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include "../subprojects/cxxopts/cxxopts.hpp"
+#include "AdaptiveCodec.hpp"
+#include "BlockCodec.hpp"
 #include "FileUtils.hpp"
 #include "HCNode.hpp"
 #include "HCTree.hpp"
+#include "MappedFile.hpp"
 
-#define TOTAL_SYMBOLS_BITS 32  // # of bits to represent total symbols
-#define NON_ZEROS_BITS 9       // # of bits to represent nonZeros
-#define BIT_IN_BYTE 8          // used for output symbol
-#define BINARY 2               // binary is base 2
-#define ASCII_MAX 256          // number of ascii values for HCTree
+#define ASCII_MAX 256  // number of ascii values for HCTree
 
 /* Perform pseudo compression with ascii encoding and naive header
  * (checkpoint). Read first file, build HCTree based on frequencies of each char
@@ -27,122 +28,115 @@
  * @param outFileName File to write compressed file to
  */
 void pseudoCompression(string inFileName, string outFileName) {
-    ifstream in(inFileName, ios::binary);  // open inFile
+    MappedFile in(inFileName);  // map inFile, read it from memory twice
 
-    HCTree tree;                            // HCTree to build and help encode
-    vector<unsigned int> freqs(ASCII_MAX);  // stores freqs from input file
+    HCTree tree;                        // HCTree to build and help encode
+    vector<uint64_t> freqs(ASCII_MAX);  // stores freqs from input file
 
-    char ch;  // stores character we are reading
-
-    while (in.get(ch)) {  // get 1 character each time until no more
-        unsigned char uch = ch;
-        freqs[uch]++;
+    for (size_t i = 0; i < in.size(); i++) {  // count each character
+        freqs[in.data()[i]]++;
     }
 
     tree.build(freqs);  // build tree
 
-    ofstream out(outFileName, ios::binary);  // open outFile
-    for (unsigned int freq : freqs) {        // output header
+    ofstream outFile;
+    ostream& out = FileUtils::openOutput(outFileName, outFile);  // open outFile
+    for (uint64_t freq : freqs) {  // output header
         out << freq << endl;
     }
 
-    in = ifstream(inFileName, ios::binary);  // reopen inFile
-    while (in.get(ch)) {                     // get 1 character and encode
-        unsigned char uch = ch;
-        tree.encode(uch, out);  // output encoding
+    for (size_t i = 0; i < in.size(); i++) {  // encode each character
+        tree.encode(in.data()[i], out);       // output encoding
     }
 
-    // close files
-    in.close();
-    out.close();
+    // close file
+    out.flush();
 }
 
-/* True compression with bitwise i/o and small header (final).
+/* True compression with bitwise i/o and small header (final). Writes the block
+ * container: the format magic and version, then each block of the input with
+ * its own canonical code. A file is mapped and read from memory, while stdin
+ * is read and compressed one block at a time.
  * @param inFileName File to read from
  * @param outFileName File to write compressed file to
+ * @param options Settings for compressing, phases are timed in options.stats
  * */
-void trueCompression(string inFileName, string outFileName) {
-    ifstream in(inFileName, ios::binary);  // open inFile
-
-    HCTree tree;                            // HCTree to build and help encode
-    vector<unsigned int> freqs(ASCII_MAX);  // stores freqs from input file
-    unsigned int nonZeros = 0;              // number of nonZero freqs
-    unsigned int totalSymbols = 0;          // number of symbols in input file
-
-    char ch;  // stores character we are reading
-
-    while (in.get(ch)) {  // get 1 character each time until no more
-        unsigned char uch = ch;
-
-        if (freqs[uch] == 0) {  // first time reading symbol
-            nonZeros++;
-        }
-        freqs[uch]++;
+void trueCompression(string inFileName, string outFileName,
+                     const BlockCodec::Options& options) {
+    Stats::Timer probe(options.stats, Stats::PROBE);
+    ofstream outFile;
+    ostream& out = FileUtils::openOutput(outFileName, outFile);  // open outFile
+    BitOutputStream outBit(out);  // Bit output stream
+
+    if (FileUtils::isStdStream(inFileName)) {
+        probe.stop();
+        BlockCodec::compress(cin, outBit, options);
+    } else {
+        MappedFile in(inFileName);  // map inFile, read it from memory once
+        probe.stop();
+        BlockCodec::compress(in.data(), in.size(), outBit, options);
     }
 
-    // get number of total symbols
-    for (unsigned int i = 0; i < freqs.size(); i++) {
-        totalSymbols += freqs[i];
+    // flush last bits stored in buffer
+    Stats::Timer flush(options.stats, Stats::FLUSH);
+    outBit.flush();
+    out.flush();
+    flush.stop();
+    if (options.stats != nullptr) {
+        options.stats->finish(outBit.getBytesWritten());
     }
-    tree.build(freqs);  // build tree
-
-    ofstream out(outFileName, ios::binary);  // open outFile
-    BitOutputStream outBit(out);             // Bit output stream
-
-    vector<int> childrenCount = tree.binaryRep();  // get tree rep for header
-    // used to get binary for totalSymbols
-    vector<unsigned int> totalSymbolBinary(TOTAL_SYMBOLS_BITS);
-    vector<unsigned int> nonZerosBinary(NON_ZEROS_BITS);  // binary for nonZeros
-    vector<unsigned int> symbolBinary(BIT_IN_BYTE);       // binary for symbols
+}
 
-    // convert totalSymbols to binary and output as part of header
-    for (int i = TOTAL_SYMBOLS_BITS - 1; i >= 0; i--) {
-        totalSymbolBinary[i] = totalSymbols % BINARY;
-        totalSymbols /= BINARY;
-    }
-    for (int i = 0; i < TOTAL_SYMBOLS_BITS; i++) {
-        outBit.writeBit(totalSymbolBinary[i]);
-    }
+/* Single pass compression with an adaptive Huffman tree. Reads the input a
+ * chunk at a time and writes each chunk out as soon as it is coded, so live
+ * streams from stdin are compressed as they arrive with constant memory.
+ * @param inFileName File to read from
+ * @param outFileName File to write compressed file to
+ * @param stats Where to time phases and count symbols, nullptr for none
+ */
+void adaptiveCompression(string inFileName, string outFileName,
+                         Stats* stats) {
+    Stats::Timer probe(stats, Stats::PROBE);
+    ifstream inFile;
+    istream& in = FileUtils::openInput(inFileName, inFile);  // open inFile
+    ofstream outFile;
+    ostream& out = FileUtils::openOutput(outFileName, outFile);  // open outFile
+    BitOutputStream outBit(out);  // Bit output stream
+    probe.stop();
+
+    AdaptiveCodec::compress(in, outBit, stats);
 
-    // convert nonZeros to binary and output as part of header
-    for (int i = NON_ZEROS_BITS - 1; i >= 0; i--) {
-        nonZerosBinary[i] = nonZeros % BINARY;
-        nonZeros /= BINARY;
-    }
-    for (int i = 0; i < NON_ZEROS_BITS; i++) {
-        outBit.writeBit(nonZerosBinary[i]);
+    // flush last bits stored in buffer
+    Stats::Timer flush(stats, Stats::FLUSH);
+    outBit.flush();
+    out.flush();
+    flush.stop();
+    if (stats != nullptr) {
+        stats->finish(outBit.getBytesWritten());
     }
+}
 
-    // output rest of header
-    for (unsigned int i = 0; i < childrenCount.size(); i++) {
-        if (childrenCount[i] == -1) {  // internal node, output 0
-            outBit.writeBit(0);
-        } else {  // leaf, output 1, then symbol converted into binary
-            outBit.writeBit(1);
-            unsigned char count = childrenCount[i];
-            // convert symbol to binary and output
-            for (int j = BIT_IN_BYTE - 1; j >= 0; j--) {
-                symbolBinary[j] = count % BINARY;
-                count /= BINARY;
-            }
-            for (int j = 0; j < BIT_IN_BYTE; j++) {
-                outBit.writeBit(symbolBinary[j]);
-            }
-        }
+/* Reports the phase times and sizes collected while compressing.
+ * @param stats Stats collected
+ * @param statsFile File to write the report to as JSON, empty for a table on
+ * stderr
+ * @param outFileName File the compressed bytes went to, JSON meant for stdout goes
+ * to stderr when they went there too
+ */
+void reportStats(const Stats& stats, string statsFile, string outFileName) {
+    if (statsFile.empty()) {
+        stats.print(cerr);
+        return;
     }
-
-    in = ifstream(inFileName, ios::binary);  // reopen inFile
-    while (in.get(ch)) {                     // get 1 character and encode
-        unsigned char uch = ch;
-        tree.encode(uch, outBit);  // output encoding
+    if (statsFile == "-" && outFileName == "-") {  // keep stdout just the data
+        stats.writeJson(cerr);
+        cerr.flush();
+        return;
     }
-
-    // flush last bits stored in buffer
-    outBit.flush();
-
-    // close files
-    in.close();
-    out.close();
+    ofstream jsonFile;
+    ostream& json = FileUtils::openOutput(statsFile, jsonFile);
+    stats.writeJson(json);
+    json.flush();
 }
 
 /* Main program that runs the compress. Checks if input file is invalid or
@@ -151,16 +145,47 @@ void trueCompression(string inFileName, string outFileName) {
  * @param argv Array of arguments
  */
 int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);  // stdin and stdout are only used as streams
+
     // option parsing for command line
     cxxopts::Options options("./compress",
                              "Compresses files using Huffman Encoding");
-    options.positional_help("./path_to_input_file ./path_to_output_file");
+    options.positional_help(
+        "./path_to_input_file ./path_to_output_file (- for stdin or stdout)");
 
     bool isAsciiOutput = false;
+    bool isAdaptive = false;
+    BlockCodec::Options codecOptions;
+    string histogram = "interleaved";
+    string statsFile;
     string inFileName, outFileName;
     options.allow_unrecognised_options().add_options()(
         "ascii", "Write output in ascii mode instead of bit stream",
         cxxopts::value<bool>(isAsciiOutput))(
+        "adaptive",
+        "Compress in a single pass with an adaptive code",
+        cxxopts::value<bool>(isAdaptive))(
+        "block-size", "Bytes of input compressed with each code",
+        cxxopts::value<size_t>(codecOptions.blockSize), "BYTES")(
+        "max-code-len", "Limit codes to at most N bits (0 for no limit)",
+        cxxopts::value<unsigned int>(codecOptions.maxCodeLength), "N")(
+        "restart-interval",
+        "Bytes between points decoding can start from (0 for none)",
+        cxxopts::value<size_t>(codecOptions.restartInterval), "BYTES")(
+        "interleave",
+        "Split each block in 4 sub-streams that decode at once, no restarts",
+        cxxopts::value<bool>(codecOptions.interleave))(
+        "context",
+        "Code each byte with a code chosen by the byte before it, no restarts",
+        cxxopts::value<bool>(codecOptions.context))(
+        "threads", "Number of threads to use (0 for one per core)",
+        cxxopts::value<unsigned int>(codecOptions.threads), "N")(
+        "histogram", "Frequency counting kernel: simple or interleaved",
+        cxxopts::value<string>(histogram), "KERNEL")(
+        "stats",
+        "Report time of each phase and sizes, as JSON with =FILE (- for "
+        "stdout, stderr if the output is stdout)",
+        cxxopts::value<string>(statsFile)->implicit_value(""), "FILE")(
         "input", "", cxxopts::value<string>(inFileName))(
         "output", "", cxxopts::value<string>(outFileName))(
         "h,help", "Print help and exit");
@@ -169,7 +194,10 @@ int main(int argc, char* argv[]) {
     auto userOptions = options.parse(argc, argv);
 
     if (userOptions.count("help") || !FileUtils::isValidFile(inFileName) ||
-        outFileName.empty()) {
+        outFileName.empty() || codecOptions.blockSize == 0 ||
+        codecOptions.blockSize > BlockCodec::MAX_BLOCK_SIZE ||
+        (codecOptions.context && codecOptions.interleave) ||
+        (histogram != "simple" && histogram != "interleaved")) {
         cout << options.help({""}) << std::endl;
         exit(0);
     }
@@ -180,16 +208,33 @@ int main(int argc, char* argv[]) {
     if (!utils.isValidFile(inFileName)) {  // invalid file
         return 0;
     } else if (utils.isEmptyFile(inFileName)) {  // empty file, create empty out
-        ofstream out(outFileName, ios::binary);  // open outFile
-        out.close();                             // close outFile
+        ofstream out;
+        FileUtils::openOutput(outFileName, out);  // open outFile
         return 0;
     }
 
+    if (codecOptions.threads == 0) {  // one thread per core
+        codecOptions.threads = max(thread::hardware_concurrency(), 1u);
+    }
+
     // No error, then compress
     if (isAsciiOutput) {
         pseudoCompression(inFileName, outFileName);
     } else {
-        trueCompression(inFileName, outFileName);
+        codecOptions.kernel = (histogram == "simple") ? Histogram::SIMPLE
+                                                      : Histogram::INTERLEAVED;
+        Stats stats;  // starts timing the whole compression
+        if (userOptions.count("stats")) {
+            codecOptions.stats = &stats;
+        }
+        if (isAdaptive) {
+            adaptiveCompression(inFileName, outFileName, codecOptions.stats);
+        } else {
+            trueCompression(inFileName, outFileName, codecOptions);
+        }
+        if (codecOptions.stats != nullptr) {
+            reportStats(stats, statsFile, outFileName);
+        }
     }
 
     return 0;
@@ -0,0 +1,234 @@
+/**
+ * A Huffman coding tree that changes as symbols go through it, using Vitter's
+ * algorithm.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "AdaptiveHCTree.hpp"
+
+/* Forgets every symbol seen, leaving only the NYT leaf. */
+void AdaptiveHCTree::reset() {
+    for (unsigned int i = 0; i < SYMBOLS; i++) {
+        leaves[i] = HCNode::NONE;
+    }
+    nodes[0] = HCNode();
+    nodeCount = 1;
+    root = 0;
+    nyt = 0;
+    numbers[0] = MAX_NODES - 1;
+    byNumber[MAX_NODES - 1] = 0;
+}
+
+/* Exchanges the places in the tree of two nodes, neither an ancestor of the
+ * other, along with their subtrees and numbers.
+ * @param a Index of a node
+ * @param b Index of another node
+ */
+void AdaptiveHCTree::swapNodes(uint16_t a, uint16_t b) {
+    uint16_t aParent = nodes[a].p;
+    uint16_t bParent = nodes[b].p;
+    if (aParent == bParent) {  // siblings only change sides
+        HCNode& parent = nodes[aParent];
+        uint16_t temp = parent.c0;
+        parent.c0 = parent.c1;
+        parent.c1 = temp;
+    } else {
+        uint16_t& aSlot = (nodes[aParent].c0 == a) ? nodes[aParent].c0
+                                                   : nodes[aParent].c1;
+        uint16_t& bSlot = (nodes[bParent].c0 == b) ? nodes[bParent].c0
+                                                   : nodes[bParent].c1;
+        aSlot = b;
+        bSlot = a;
+        nodes[a].p = bParent;
+        nodes[b].p = aParent;
+    }
+
+    uint16_t temp = numbers[a];
+    numbers[a] = numbers[b];
+    numbers[b] = temp;
+    byNumber[numbers[a]] = a;
+    byNumber[numbers[b]] = b;
+}
+
+/* Returns whether the node with the next higher number is in the given block:
+ * of leaves or of internal nodes, of the given weight.
+ * @param node Index of the node before it
+ * @param leaf Whether the block is of leaves
+ * @param weight Weight of the block
+ * @return true if there is a next node and it is in the block
+ */
+bool AdaptiveHCTree::nextInBlock(uint16_t node, bool leaf,
+                                 uint64_t weight) const {
+    if (numbers[node] + 1u >= MAX_NODES) {  // node is the root
+        return false;
+    }
+    const HCNode& next = nodes[byNumber[numbers[node] + 1]];
+    return next.isLeaf() == leaf && next.count == weight;
+}
+
+/* Moves a node ahead of the block that its weight is about to pass and
+ * increments the weight. A leaf of weight w passes the internal nodes of
+ * weight w, and an internal node of weight w passes the leaves of weight
+ * w + 1. Nodes passed each move down one place.
+ * @param node Index of the node
+ * @return index of the next node to increment, NONE after the root
+ */
+uint16_t AdaptiveHCTree::slideAndIncrement(uint16_t node) {
+    uint64_t weight = nodes[node].count;
+    bool leaf = nodes[node].isLeaf();
+    uint16_t formerParent = nodes[node].p;
+
+    // the rest of the node's own block comes first
+    while (nextInBlock(node, leaf, weight)) {
+        swapNodes(node, byNumber[numbers[node] + 1]);
+    }
+    // then the block its new weight passes
+    bool passLeaves = !leaf;
+    uint64_t passWeight = leaf ? weight : weight + 1;
+    while (nextInBlock(node, passLeaves, passWeight)) {
+        swapNodes(node, byNumber[numbers[node] + 1]);
+    }
+
+    nodes[node].count++;
+    // a leaf's new parent still needs the weight, an internal node took its
+    // weight with it so its former parent is next
+    return leaf ? nodes[node].p : formerParent;
+}
+
+/* Adds one to the count of a symbol, changing the tree to stay a Huffman tree.
+ * A symbol not seen yet gets a new leaf split from the NYT leaf.
+ * @param symbol Symbol just coded
+ */
+void AdaptiveHCTree::update(byte symbol) {
+    uint16_t leafToIncrement = HCNode::NONE;
+    uint16_t node = leaves[symbol];
+
+    if (node == HCNode::NONE) {  // split NYT into a new NYT and the symbol
+        uint16_t newNyt = nodeCount++;
+        uint16_t leaf = nodeCount++;
+        nodes[newNyt] = HCNode(0, 0, HCNode::NONE, HCNode::NONE, nyt);
+        nodes[leaf] = HCNode(0, symbol, HCNode::NONE, HCNode::NONE, nyt);
+        nodes[nyt].c0 = newNyt;
+        nodes[nyt].c1 = leaf;
+        numbers[leaf] = numbers[nyt] - 1;
+        numbers[newNyt] = numbers[nyt] - 2;
+        byNumber[numbers[leaf]] = leaf;
+        byNumber[numbers[newNyt]] = newNyt;
+        leaves[symbol] = leaf;
+
+        node = nyt;
+        nyt = newNyt;
+        leafToIncrement = leaf;
+    } else {
+        // the leader of the node's block, the highest numbered leaf of the
+        // same weight, can take the weight without breaking the order
+        uint16_t leader = node;
+        while (nextInBlock(leader, true, nodes[node].count)) {
+            leader = byNumber[numbers[leader] + 1];
+        }
+        if (leader != node) {
+            swapNodes(node, leader);
+        }
+
+        // a leaf next to NYT weighs as much as its parent, so the parent
+        // goes first to stay ahead of it
+        const HCNode& parent = nodes[nodes[node].p];
+        if (parent.c0 == nyt || parent.c1 == nyt) {
+            leafToIncrement = node;
+            node = nodes[node].p;
+        }
+    }
+
+    while (node != HCNode::NONE) {
+        node = slideAndIncrement(node);
+    }
+    if (leafToIncrement != HCNode::NONE) {
+        slideAndIncrement(leafToIncrement);
+    }
+}
+
+/* Writes the code of a symbol, then updates the tree.
+ * @param symbol Symbol to encode
+ * @param out BitOutputStream to write the code to
+ */
+void AdaptiveHCTree::encode(byte symbol, BitOutputStream& out) {
+    uint16_t leaf = leaves[symbol];
+    uint16_t node = (leaf == HCNode::NONE) ? nyt : leaf;
+
+    // path from the node up to the root, written from the root down
+    byte path[SYMBOLS + 1];  // no leaf is deeper than there are leaves
+    unsigned int length = 0;
+    for (uint16_t curr = node; curr != root; curr = nodes[curr].p) {
+        path[length++] = (nodes[nodes[curr].p].c1 == curr) ? 1 : 0;
+    }
+    uint64_t code = 0;
+    unsigned int bits = 0;
+    while (length > 0) {
+        code = (code << 1) | path[--length];
+        if (++bits == MAX_WRITE_BITS) {
+            out.writeBits(code, bits);
+            code = 0;
+            bits = 0;
+        }
+    }
+    if (bits != 0) {
+        out.writeBits(code, bits);
+    }
+
+    if (leaf == HCNode::NONE) {  // new symbol follows the NYT code
+        out.writeBits(symbol, SYMBOL_BITS);
+    }
+    update(symbol);
+}
+
+/* Reads the code of a symbol, then updates the tree.
+ * @param in BitInputStream to read the code from
+ * @return decoded symbol
+ */
+byte AdaptiveHCTree::decode(BitInputStream& in) {
+    uint16_t curr = root;
+    while (!nodes[curr].isLeaf()) {  // follow the bits down to a leaf
+        curr = in.readBit() ? nodes[curr].c1 : nodes[curr].c0;
+    }
+
+    byte symbol = nodes[curr].symbol;
+    if (curr == nyt) {  // new symbol follows the NYT code
+        symbol = in.readBits(SYMBOL_BITS);
+    }
+    update(symbol);
+    return symbol;
+}
+
+/* Helper for testing. Returns whether every internal node weighs as much as
+ * its children, and the numbering keeps weights in order with leaves before
+ * internal nodes of the same weight.
+ * @return true if the tree is consistent
+ */
+bool AdaptiveHCTree::isConsistent() const {
+    for (unsigned int number = numbers[nyt]; number < MAX_NODES; number++) {
+        uint16_t index = byNumber[number];
+        const HCNode& node = nodes[index];
+        if (numbers[index] != number) {
+            return false;
+        }
+        if (!node.isLeaf()) {
+            const HCNode& c0 = nodes[node.c0];
+            const HCNode& c1 = nodes[node.c1];
+            if (c0.p != index || c1.p != index ||
+                node.count != c0.count + c1.count ||
+                numbers[node.c0] >= number || numbers[node.c1] >= number) {
+                return false;
+            }
+        }
+        if (number + 1 < MAX_NODES) {  // order against the next node
+            const HCNode& next = nodes[byNumber[number + 1]];
+            if (next.count < node.count ||
+                (next.count == node.count && next.isLeaf() &&
+                 !node.isLeaf())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+/**
+ * Header file of AdaptiveHCTree, a Huffman coding tree that changes as symbols
+ * go through it, using Vitter's algorithm. The encoder and decoder start from
+ * the same tree and update it the same way after every symbol, so no header is
+ * needed and symbols can be coded as soon as they arrive.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef ADAPTIVEHCTREE_HPP
+#define ADAPTIVEHCTREE_HPP
+
+#include <cstdint>
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "HCNode.hpp"
+
+using namespace std;
+
+/** Class for AdaptiveHCTree that keeps a Huffman tree of the symbols seen so
+ *  far. Symbols not seen yet are coded as the code of the NYT (not yet
+ *  transmitted) leaf followed by the symbol's 8 bits. Nodes are numbered from
+ *  the bottom of the tree up and left to right. Node weights never go down
+ *  with the numbering, and leaves come before internal nodes of the same
+ *  weight, which keeps the tree a Huffman tree of the counts.
+ */
+class AdaptiveHCTree {
+  private:
+    static const unsigned int SYMBOLS = 256;  // number of byte values
+    static const unsigned int SYMBOL_BITS = 8;  // bits of a new symbol
+    static const unsigned int MAX_WRITE_BITS = 64;  // bits written at once
+    static const unsigned int MAX_NODES = 2 * (SYMBOLS + 1) - 1;  // nodes of
+                                                                  // a full
+                                                                  // tree, NYT
+                                                                  // included
+
+    HCNode nodes[MAX_NODES];       // all nodes of the tree
+    unsigned int nodeCount;        // number of nodes used in nodes
+    uint16_t root;                 // index of the root
+    uint16_t nyt;                  // index of the NYT leaf
+    uint16_t leaves[SYMBOLS];      // index of each symbol's leaf, or NONE
+    uint16_t numbers[MAX_NODES];   // number of each node, root the highest
+    uint16_t byNumber[MAX_NODES];  // index of the node with each number
+
+    /* Exchanges the places in the tree of two nodes, neither an ancestor of
+     * the other, along with their subtrees and numbers.
+     * @param a Index of a node
+     * @param b Index of another node
+     */
+    void swapNodes(uint16_t a, uint16_t b);
+
+    /* Returns whether the node with the next higher number is in the given
+     * block: of leaves or of internal nodes, of the given weight.
+     * @param node Index of the node before it
+     * @param leaf Whether the block is of leaves
+     * @param weight Weight of the block
+     * @return true if there is a next node and it is in the block
+     */
+    bool nextInBlock(uint16_t node, bool leaf, uint64_t weight) const;
+
+    /* Moves a node ahead of the block that its weight is about to pass and
+     * increments the weight.
+     * @param node Index of the node
+     * @return index of the next node to increment, NONE after the root
+     */
+    uint16_t slideAndIncrement(uint16_t node);
+
+    /* Adds one to the count of a symbol, changing the tree to stay a Huffman
+     * tree. A symbol not seen yet gets a new leaf split from the NYT leaf.
+     * @param symbol Symbol just coded
+     */
+    void update(byte symbol);
+
+  public:
+    /* Constructor of AdaptiveHCTree.
+     * Starts with only the NYT leaf. */
+    AdaptiveHCTree() { reset(); }
+
+    /* Forgets every symbol seen, leaving only the NYT leaf. */
+    void reset();
+
+    /* Writes the code of a symbol, then updates the tree.
+     * @param symbol Symbol to encode
+     * @param out BitOutputStream to write the code to
+     */
+    void encode(byte symbol, BitOutputStream& out);
+
+    /* Reads the code of a symbol, then updates the tree.
+     * @param in BitInputStream to read the code from
+     * @return decoded symbol
+     */
+    byte decode(BitInputStream& in);
+
+    /* Helper for testing. Returns whether every internal node weighs as much
+     * as its children, and the numbering keeps weights in order with leaves
+     * before internal nodes of the same weight.
+     * @return true if the tree is consistent
+     */
+    bool isConsistent() const;
+};
+
+#endif  // ADAPTIVEHCTREE_HPP
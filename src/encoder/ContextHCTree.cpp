@@ -0,0 +1,78 @@
+/**
+ * A set of canonical Huffman codes with one code for each value of the
+ * previous byte.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "ContextHCTree.hpp"
+
+#define ASCII_MAX 256  // symbols coded in each context
+
+const unsigned int ContextHCTree::CONTEXTS;
+
+/* Builds canonical codes for every context from a 256 x 256 histogram filled
+ * by Histogram::countContexts. Contexts left unused are cleared, so one
+ * ContextHCTree can code many blocks.
+ * @param freqs Frequency of each symbol after each previous byte
+ * @param maxCodeLength Longest code length allowed, 0 for no limit
+ */
+void ContextHCTree::build(const vector<uint64_t>& freqs,
+                          unsigned int maxCodeLength) {
+    vector<uint64_t> row(ASCII_MAX);
+    for (unsigned int context = 0; context < CONTEXTS; context++) {
+        auto first = freqs.begin() + context * ASCII_MAX;
+        row.assign(first, first + ASCII_MAX);
+
+        bool wasUsed = used[context];
+        used[context] = false;
+        for (uint64_t freq : row) {
+            if (freq != 0) {
+                used[context] = true;
+                break;
+            }
+        }
+        if (used[context]) {  // rebuilt in place
+            trees[context].buildCanonical(row, maxCodeLength);
+        } else if (wasUsed) {
+            trees[context].clear();
+        }
+    }
+}
+
+/* Writes one bit per context, each set bit followed by the context's code
+ * lengths.
+ * @param outBit BitOutputStream to write the header to
+ */
+void ContextHCTree::writeCodeLengths(BitOutputStream& outBit) const {
+    for (unsigned int context = 0; context < CONTEXTS; context++) {
+        outBit.writeBit(used[context]);
+        if (used[context]) {
+            trees[context].writeCodeLengths(outBit);
+        }
+    }
+}
+
+/* Builds canonical codes from a header written by writeCodeLengths,
+ * clearing the contexts it leaves unused.
+ * @param inBit BitInputStream to read the header from
+ */
+void ContextHCTree::buildWithCodeLengths(BitInputStream& inBit) {
+    for (unsigned int context = 0; context < CONTEXTS; context++) {
+        bool wasUsed = used[context];
+        used[context] = inBit.readBit();
+        if (used[context]) {  // rebuilt in place
+            trees[context].buildWithCodeLengths(inBit);
+        } else if (wasUsed) {
+            trees[context].clear();
+        }
+    }
+}
+
+/* Returns the code length of every symbol after the given byte.
+ * @param previous Byte before the symbols
+ * @return code lengths vector, all 0 if the context is unused
+ */
+vector<byte> ContextHCTree::getCodeLengths(byte previous) const {
+    return trees[previous].getCodeLengths();
+}
@@ -0,0 +1,85 @@
+/**
+ * Header file of ContextHCTree, a set of canonical Huffman codes with one code
+ * for each value of the previous byte. Text is much more predictable from the
+ * byte before, so each code only has to tell apart the bytes that follow one
+ * context.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef CONTEXTHCTREE_HPP
+#define CONTEXTHCTREE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "HCTree.hpp"
+
+using namespace std;
+
+/** Class for ContextHCTree that keeps an HCTree with canonical codes for each
+ *  previous byte. Only contexts that appear get a code, and the header holds
+ *  one bit per context saying whether its code lengths follow.
+ */
+class ContextHCTree {
+  public:
+    static const unsigned int CONTEXTS = 256;  // one code per previous byte
+    static const unsigned int MAX_HEADER_BITS =  // longest header, a used bit
+        CONTEXTS * (1 + HCTree::MAX_HEADER_BITS);  // and lengths per context
+
+    /* Constructor of ContextHCTree.
+     * Starts with no context used. */
+    ContextHCTree() : trees(CONTEXTS), used(CONTEXTS) {}
+
+    /* Builds canonical codes for every context from a 256 x 256 histogram
+     * filled by Histogram::countContexts. Contexts left unused are cleared,
+     * so one ContextHCTree can code many blocks.
+     * @param freqs Frequency of each symbol after each previous byte
+     * @param maxCodeLength Longest code length allowed, 0 for no limit
+     */
+    void build(const vector<uint64_t>& freqs, unsigned int maxCodeLength = 0);
+
+    /* Writes one bit per context, each set bit followed by the context's code
+     * lengths.
+     * @param outBit BitOutputStream to write the header to
+     */
+    void writeCodeLengths(BitOutputStream& outBit) const;
+
+    /* Builds canonical codes from a header written by writeCodeLengths,
+     * clearing the contexts it leaves unused.
+     * @param inBit BitInputStream to read the header from
+     */
+    void buildWithCodeLengths(BitInputStream& inBit);
+
+    /* Writes the code of a symbol in the context of the byte before it.
+     * @param previous Byte before the symbol
+     * @param symbol Symbol to encode
+     * @param out BitOutputStream to write the code to
+     */
+    void encode(byte previous, byte symbol, BitOutputStream& out) const {
+        trees[previous].encode(symbol, out);
+    }
+
+    /* Decodes the next symbol in the context of the byte before it, through
+     * that context's decoding table.
+     * @param previous Byte before the symbol
+     * @param in BitInputStream to take input bits from
+     * @return decoded symbol
+     */
+    byte decode(byte previous, BitInputStream& in) const {
+        return trees[previous].decode(in);
+    }
+
+    /* Returns the code length of every symbol after the given byte.
+     * @param previous Byte before the symbols
+     * @return code lengths vector, all 0 if the context is unused
+     */
+    vector<byte> getCodeLengths(byte previous) const;
+
+  private:
+    vector<HCTree> trees;  // code of each context
+    vector<bool> used;     // whether each context has a code
+};
+
+#endif  // CONTEXTHCTREE_HPP
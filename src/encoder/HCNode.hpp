@@ -3,6 +3,7 @@
  * elements in the HCTree. An HCNode node has higher priority if it has a lower
  * count or if it has equal count but higher ascii value. Higher priority is the
  * c0 child if exists. And symbol of parents of leaves are based on c1 child.
+ * Nodes live in their HCTree's node array and refer to each other by index.
  *
  * Author: Aimee T Shao
  * PID: A15444996
@@ -10,6 +11,7 @@
 #ifndef HCNODE_HPP
 #define HCNODE_HPP
 
+#include <cstdint>
 #include <iostream>
 
 typedef unsigned char byte;
@@ -20,16 +22,23 @@ using namespace std;
  */
 class HCNode {
   public:
-    unsigned int count;  // the freqency of the symbol
+    static const uint16_t NONE = 0xFFFF;  // index standing for no node
+
+    uint64_t count;      // the freqency of the symbol
     byte symbol;         // byte in the file we're keeping track of
-    HCNode* c0;          // pointer to '0' child
-    HCNode* c1;          // pointer to '1' child
-    HCNode* p;           // pointer to parent
+    uint16_t c0;         // index of '0' child
+    uint16_t c1;         // index of '1' child
+    uint16_t p;          // index of parent
 
     /* Constructor that initialize a HCNode */
-    HCNode(unsigned int count, byte symbol, HCNode* c0 = 0, HCNode* c1 = 0,
-           HCNode* p = 0)
+    HCNode(uint64_t count = 0, byte symbol = 0, uint16_t c0 = NONE,
+           uint16_t c1 = NONE, uint16_t p = NONE)
         : count(count), symbol(symbol), c0(c0), c1(c1), p(p) {}
+
+    /* Returns whether the node is a leaf.
+     * @return true if the node has no children
+     */
+    bool isLeaf() const { return c0 == NONE && c1 == NONE; }
 };
 
 /* For printing an HCNode to an ostream. Possibly useful for debugging */
@@ -9,137 +9,377 @@
  * PID: A15444996
  */
 #include "HCTree.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <stack>
+#include <string>
 
 #define BIT_IN_BYTE 8  // used for output symbol
-#define BINARY 2       // binary is base 2
 #define ZERO_LITERAL '0'
 #define ONE_LITERAL '1'
-
-/* Deconstructor.
- * Deallocates the memory of the HCTree and all the HCNodes inside of it.
+#define RADIX_BITS 8  // bits of a count sorted per pass
+#define RADIX_SIZE (1 << RADIX_BITS)  // buckets of a sorting pass
+
+/* Sorts the leaves from highest to lowest priority: by count from low to
+ * high, equal counts by symbol from high to low. Leaves are put in symbol
+ * order from high to low and then radix sorted by count one byte at a time,
+ * which keeps the order of equal counts.
+ * @param sorted Where to store the indices of the leaves, room for SYMBOLS
+ * @return number of leaves
  */
-HCTree::~HCTree() { deleteHCNodes(root); }
+unsigned int HCTree::sortLeaves(uint16_t* sorted) const {
+    unsigned int leafCount = 0;
+    uint64_t highest = 0;  // largest count, no more passes than its bytes
+    for (int i = SYMBOLS - 1; i >= 0; i--) {
+        if (leaves[i] != HCNode::NONE) {
+            sorted[leafCount++] = leaves[i];
+            highest = max(highest, nodes[leaves[i]].count);
+        }
+    }
+
+    uint16_t temp[SYMBOLS];
+    uint16_t* from = sorted;
+    uint16_t* to = temp;
+    for (unsigned int shift = 0; shift < sizeof(highest) * BIT_IN_BYTE &&
+                                 (highest >> shift) != 0;
+         shift += RADIX_BITS) {
+        unsigned int starts[RADIX_SIZE + 1] = {0};
+        for (unsigned int i = 0; i < leafCount; i++) {
+            starts[((nodes[from[i]].count >> shift) & (RADIX_SIZE - 1)) + 1]++;
+        }
+        for (unsigned int digit = 1; digit <= RADIX_SIZE; digit++) {
+            starts[digit] += starts[digit - 1];
+        }
+        for (unsigned int i = 0; i < leafCount; i++) {
+            to[starts[(nodes[from[i]].count >> shift) & (RADIX_SIZE - 1)]++] =
+                from[i];
+        }
+        swap(from, to);
+    }
+    if (from != sorted) {  // odd number of passes left them in temp
+        copy(from, from + leafCount, sorted);
+    }
+    return leafCount;
+}
 
 /* Builds the HCTree from a given frequency vector. Only non-zero frequencies
- * go in the tree.
+ * go in the tree. A tree deeper than MAX_CODE_LENGTH keeps its code lengths
+ * but gets no codes or decoding table, so it only encodes and decodes as 0 and
+ * 1 characters.
  * @param freqs Frequency counts of ascii characters
+ * @param ties How merged nodes of equal count are ordered
  */
-void HCTree::build(const vector<unsigned int>& freqs) {
-    // create priority queue for sorting nodes
-    priority_queue<HCNode*, vector<HCNode*>, HCNodePtrComp> pq;
+void HCTree::build(const vector<uint64_t>& freqs, TieBreak ties) {
+    buildTree(freqs, ties);
+    buildCodeTable();
+    buildDecodeTable();
+}
 
-    for (unsigned int i = 0; i < freqs.size(); i++) {  // loop freqs, add leaves
+/* Builds only the nodes of the Huffman tree, without any codes. Leaves are
+ * sorted once, then the two nodes to merge are always at the front of the
+ * sorted leaves or of the queue of merged nodes, since merged nodes are made
+ * with counts that never go down.
+ * @param freqs Frequency counts of ascii characters
+ * @param ties How merged nodes of equal count are ordered
+ */
+void HCTree::buildTree(const vector<uint64_t>& freqs, TieBreak ties) {
+    clearNodes();
+
+    for (unsigned int i = 0; i < freqs.size() && i < SYMBOLS; i++) {
         if (freqs.at(i) != 0) {  // only add symbols that don't have 0 freq
-            HCNode* node = new HCNode(freqs.at(i), i);
-            // add node to leaves vector and pq
-            leaves[i] = node;
-            pq.push(node);
+            leaves[i] = addNode(HCNode(freqs.at(i), i));
         }
     }
 
-    while (pq.size() > 1) {  // loop until we reach one root
-        // get top two nodes (with lowest frequency or higher ascii)
-        HCNode* leftNode = pq.top();
-        pq.pop();
-        HCNode* rightNode = pq.top();
-        pq.pop();
-
-        // create leftNode and rightNode's parent and assign respective pointers
-        HCNode* parent =
-            new HCNode(leftNode->count + rightNode->count, rightNode->symbol);
-        leftNode->p = parent;
-        rightNode->p = parent;
-        parent->c0 = leftNode;
-        parent->c1 = rightNode;
+    uint16_t sorted[SYMBOLS];  // leaves, highest priority first
+    unsigned int leafCount = sortLeaves(sorted);
+    unsigned int leafNext = 0;
+    uint16_t merged[SYMBOLS];  // merged nodes, highest priority first
+    unsigned int mergedNext = 0;
+    unsigned int mergedCount = 0;
+
+    auto lowerPriority = [this](uint16_t lhs, uint16_t rhs) {
+        HCNode* lhsNode = &nodes[lhs];
+        HCNode* rhsNode = &nodes[rhs];
+        return HCNodePtrComp()(lhsNode, rhsNode);
+    };
+    // takes the node with highest priority of the two queues
+    auto takeNext = [&]() {
+        if (leafNext == leafCount ||
+            (mergedNext < mergedCount &&
+             lowerPriority(sorted[leafNext], merged[mergedNext]))) {
+            return merged[mergedNext++];
+        }
+        return sorted[leafNext++];
+    };
 
-        // push parent into pq to be considered for root
-        pq.push(parent);
+    // loop until we reach one root
+    while (leafCount - leafNext + mergedCount - mergedNext > 1) {
+        // get top two nodes (with lowest frequency or higher ascii)
+        uint16_t leftNode = takeNext();
+        uint16_t rightNode = takeNext();
+
+        // create leftNode and rightNode's parent and assign respective indices
+        uint16_t parent =
+            addNode(HCNode(nodes[leftNode].count + nodes[rightNode].count,
+                           nodes[rightNode].symbol, leftNode, rightNode));
+        nodes[leftNode].p = parent;
+        nodes[rightNode].p = parent;
+
+        // queue parent to be considered for root, moving it ahead of merged
+        // nodes of equal count and lower symbol as a priority queue would
+        unsigned int at = mergedCount++;
+        if (ties == SYMBOL_ORDER) {
+            while (at > mergedNext && lowerPriority(merged[at - 1], parent)) {
+                merged[at] = merged[at - 1];
+                at--;
+            }
+        }
+        merged[at] = parent;
     }
 
-    // if there is a node, last node in pq is root node
-    if (pq.size() == 1) {
-        root = pq.top();
-        pq.pop();
+    // if there is a node, the one left is the root node
+    if (leafNext < leafCount) {
+        root = sorted[leafNext];
+    } else if (mergedNext < mergedCount) {
+        root = merged[mergedNext];
     }
 }
 
 /* Builds the HCTree by reading in bit by bit. 0 for internal node or 1 for leaf
- * node then reads in symbol.
+ * node then reads in symbol. Stops early on a header that does not describe a
+ * tree.
  * @param inBit BitInputStream to read from
  * @param nonZeros Number of non zero freqs
  */
 void HCTree::buildWithHeader(BitInputStream& inBit, unsigned int nonZeros) {
+    clearNodes();
     unsigned int headerBit = 0;
-    stack<HCNode*> nodes;  // stores nodes to build tree
+    uint16_t stack[MAX_NODES];  // stores nodes to build tree
+    size_t stackSize = 0;
 
     // keep reading bits until we read all symbols and down to last node = root
-    while (nodes.size() > 1 || nonZeros != 0) {
+    while (stackSize > 1 || nonZeros != 0) {
         headerBit = inBit.readBit();  // read next bit
 
         if (headerBit == 0) {  // internal node, combine two nodes
+            if (stackSize < 2 || nodeCount == MAX_NODES) {
+                break;
+            }
             // gets first two leaf nodes
-            HCNode* c1 = nodes.top();
-            nodes.pop();
-            HCNode* c0 = nodes.top();
-            nodes.pop();
+            uint16_t c1 = stack[--stackSize];
+            uint16_t c0 = stack[--stackSize];
 
             // creates the parent for those two leaf nodes
-            HCNode* parent = new HCNode(0, 0, c0, c1, 0);
-            c0->p = parent;
-            c1->p = parent;
-            nodes.push(parent);
+            uint16_t parent = addNode(HCNode(0, 0, c0, c1));
+            nodes[c0].p = parent;
+            nodes[c1].p = parent;
+            stack[stackSize++] = parent;
         } else {  // symbol, so create leaf node and push to nodes stack
-
-            // recreate symbol from binary
-            unsigned char symbol = 0;
-            for (int i = 0; i < BIT_IN_BYTE; i++) {
-                symbol *= BINARY;
-                symbol += inBit.readBit();
+            if (nodeCount == MAX_NODES) {
+                break;
             }
 
+            // read symbol that follows in binary
+            byte symbol = inBit.readBits(BIT_IN_BYTE);
+
             // create new leaf node and push to nodes stack
-            HCNode* leaf = new HCNode(0, symbol, 0, 0, 0);
-            nodes.push(leaf);
+            uint16_t leaf = addNode(HCNode(0, symbol));
+            stack[stackSize++] = leaf;
 
-            // add to leaves vector for tree
+            // add to leaves for tree
             leaves[symbol] = leaf;
             nonZeros--;
         }
     }
-    root = nodes.top();  // root is last node in nodes
-    nodes.pop();
+    if (stackSize != 0) {
+        root = stack[stackSize - 1];  // root is last node in stack
+    }
+    buildCodeTable();
+    buildDecodeTable();
 }
 
-/* Writes the encoding bits of given symbol to given BitOutputStream.
- * @param symbol to encode into bits and to write to BitOutputStream
- * @param out BitOutputStream to write encoded bit to
+/* Builds canonical codes for the given frequency vector. Code lengths come
+ * from the Huffman tree, which is not kept afterwards. If the tree is deeper
+ * than maxCodeLength, optimal lengths within the limit are used instead. The
+ * limit is raised if too small to give every used symbol a code.
+ * @param freqs Frequency counts
+ * @param maxCodeLength Longest code length allowed, 0 for MAX_CODE_LENGTH
  */
-void HCTree::encode(byte symbol, BitOutputStream& out) const {
-    HCNode* curr = leaves[symbol];  // node to keep track of encoding 0 or 1
-    vector<unsigned int> encoding;  // encoding for symbol
+void HCTree::buildCanonical(const vector<uint64_t>& freqs,
+                            unsigned int maxCodeLength) {
+    buildTree(freqs);
+    buildCodeTable();  // only the lengths are used
+
+    // no code can be longer than the codes table holds
+    if (maxCodeLength == 0 || maxCodeLength > MAX_CODE_LENGTH) {
+        maxCodeLength = MAX_CODE_LENGTH;
+    }
+    byte longest = *max_element(codeLengths.begin(), codeLengths.end());
+    if (longest <= maxCodeLength) {
+        buildWithCodeLengths(codeLengths);
+    } else {
+        buildWithCodeLengths(limitedCodeLengths(freqs, maxCodeLength));
+    }
+}
 
-    if (curr == nullptr) {  // symbol does not exist in tree
-        return;
+/* Computes optimal code lengths no longer than maxCodeLength using the
+ * package-merge algorithm. Starting from the leaves sorted by frequency, each
+ * round pairs up the items of the previous list into packages and merges them
+ * with the leaves again. After maxCodeLength - 1 rounds, the first 2n - 2 items
+ * are picked and each symbol's code length is how often it appears in them.
+ * @param freqs Frequency counts
+ * @param maxCodeLength Longest code length allowed
+ * @return code length of each symbol, 0 if the symbol is unused
+ */
+vector<byte> HCTree::limitedCodeLengths(const vector<uint64_t>& freqs,
+                                        unsigned int maxCodeLength) {
+    // item of a package-merge list, either a leaf or a package of two items
+    struct Item {
+        uint64_t weight;  // total frequency of the leaves in the item
+        int symbol;       // symbol of a leaf, -1 for a package
+        int c0;           // index of first packaged item
+        int c1;           // index of second packaged item
+    };
+    vector<Item> items;
+    vector<byte> lengths(freqs.size());
+
+    // leaves sorted by frequency, ties by symbol
+    vector<int> leafItems;
+    for (unsigned int i = 0; i < freqs.size(); i++) {
+        if (freqs[i] != 0) {
+            leafItems.push_back(items.size());
+            items.push_back(Item{freqs[i], (int)i, -1, -1});
+        }
+    }
+    if (leafItems.size() <= 2) {  // one bit per symbol is all it takes
+        for (int leaf : leafItems) {
+            lengths[items[leaf].symbol] = 1;
+        }
+        return lengths;
+    }
+    stable_sort(leafItems.begin(), leafItems.end(), [&items](int lhs, int rhs) {
+        return items[lhs].weight < items[rhs].weight;
+    });
+
+    // need at least as many codes of maxCodeLength bits as symbols
+    while (maxCodeLength < MAX_CODE_LENGTH &&
+           ((uint64_t)1 << maxCodeLength) < leafItems.size()) {
+        maxCodeLength++;
+    }
+
+    vector<int> list = leafItems;
+    for (unsigned int round = 1; round < maxCodeLength; round++) {
+        // package up pairs of items from the previous list
+        vector<int> packages;
+        for (unsigned int i = 0; i + 1 < list.size(); i += 2) {
+            packages.push_back(items.size());
+            items.push_back(Item{items[list[i]].weight +
+                                     items[list[i + 1]].weight,
+                                 -1, list[i], list[i + 1]});
+        }
+
+        // merge packages with the leaves, leaves first on equal weight
+        list.clear();
+        merge(leafItems.begin(), leafItems.end(), packages.begin(),
+              packages.end(), back_inserter(list), [&items](int lhs, int rhs) {
+                  return items[lhs].weight < items[rhs].weight;
+              });
+    }
+
+    // every leaf inside a picked item gets one bit longer
+    stack<int> picked;
+    for (unsigned int i = 0; i < 2 * leafItems.size() - 2; i++) {
+        picked.push(list[i]);
+    }
+    while (!picked.empty()) {
+        const Item& item = items[picked.top()];
+        picked.pop();
+        if (item.symbol >= 0) {
+            lengths[item.symbol]++;
+        } else {
+            picked.push(item.c0);
+            picked.push(item.c1);
+        }
     }
-    while (curr->p) {  // loop up the tree until we reach root
-        // check if c0 or c1 child to add encoding
-        if (curr->p->c0 == curr) {
-            encoding.push_back(0);
-        } else if (curr->p->c1 == curr) {
-            encoding.push_back(1);
+    return lengths;
+}
+
+/* Builds canonical codes from the code length of every symbol. No HCNodes are
+ * created. Symbols missing from lengths are unused, lengths past the last byte
+ * value are ignored and lengths above MAX_CODE_LENGTH are cut down to it.
+ * @param lengths Code length of each symbol, 0 if the symbol is unused
+ */
+void HCTree::buildWithCodeLengths(const vector<byte>& lengths) {
+    // copy first, lengths may be our own codeLengths
+    vector<byte> copied(SYMBOLS);
+    for (unsigned int i = 0; i < SYMBOLS && i < lengths.size(); i++) {
+        copied[i] = (lengths[i] > MAX_CODE_LENGTH) ? MAX_CODE_LENGTH
+                                                   : lengths[i];
+    }
+    codeLengths.swap(copied);
+
+    // drop any tree, it would not match the canonical codes
+    clearNodes();
+
+    assignCanonicalCodes();
+    buildDecodeTable();
+}
+
+/* Builds canonical codes from a code length header.
+ * @param inBit BitInputStream to read the header from
+ */
+void HCTree::buildWithCodeLengths(BitInputStream& inBit) {
+    vector<byte> lengths(codeLengths.size());
+    unsigned int width = inBit.readBits(LENGTH_WIDTH_BITS);
+
+    for (unsigned int i = 0; i < lengths.size(); i++) {
+        unsigned int length = inBit.readBits(width);
+        lengths[i] = (length > MAX_CODE_LENGTH) ? MAX_CODE_LENGTH : length;
+        if (lengths[i] == 0) {  // skip over run of unused symbols
+            i += inBit.readBits(ZERO_RUN_BITS);
         }
-        curr = curr->p;
     }
+    buildWithCodeLengths(lengths);
+}
 
-    // if no encoding, then theres only one leaf and encoding will just be 0
-    if (encoding.size() == 0) {
-        out.writeBit(0);
-    } else {  // print out encoding bits in reverse order
-        for (int i = encoding.size() - 1; i >= 0; i--) {
-            out.writeBit(encoding[i]);
+/* Writes the code lengths of all symbols as header. Writes how many bits each
+ * length takes, then the lengths in symbol order where a length of 0 is
+ * followed by how many more unused symbols come after it.
+ * @param outBit BitOutputStream to write the header to
+ */
+void HCTree::writeCodeLengths(BitOutputStream& outBit) const {
+    // width just big enough for the longest code
+    unsigned int width = 1;
+    for (unsigned int i = 0; i < codeLengths.size(); i++) {
+        while ((codeLengths[i] >> width) != 0) {
+            width++;
         }
     }
+    outBit.writeBits(width, LENGTH_WIDTH_BITS);
+
+    for (unsigned int i = 0; i < codeLengths.size(); i++) {
+        outBit.writeBits(codeLengths[i], width);
+        if (codeLengths[i] == 0) {  // count unused symbols right after
+            unsigned int run = 0;
+            while (i + 1 < codeLengths.size() && codeLengths[i + 1] == 0 &&
+                   run < (1 << ZERO_RUN_BITS) - 1) {
+                run++;
+                i++;
+            }
+            outBit.writeBits(run, ZERO_RUN_BITS);
+        }
+    }
+}
+
+/* Writes the encoding bits of given symbol to given BitOutputStream. Looks the
+ * codeword up in the code table computed when building.
+ * @param symbol to encode into bits and to write to BitOutputStream
+ * @param out BitOutputStream to write encoded bit to
+ */
+void HCTree::encode(byte symbol, BitOutputStream& out) const {
+    out.writeBits(codes[symbol], codeLengths[symbol]);
 }
 
 /* Writes the encoding bits of given symbol to ostream as 0 or 1.
@@ -147,75 +387,164 @@ void HCTree::encode(byte symbol, BitOutputStream& out) const {
  * @param out ostream to write encoded bit to
  */
 void HCTree::encode(byte symbol, ostream& out) const {
-    HCNode* curr = leaves[symbol];  // node to keep track of encoding 0 or 1
-    vector<unsigned int> encoding;  // encoding for symbol
-
-    if (curr == nullptr) {  // symbol does not exist in tree
-        return;
-    }
-    while (curr->p) {  // loop up the tree until we reach root
-        // check if c0 or c1 child to add encoding
-        if (curr->p->c0 == curr) {
-            encoding.push_back(0);
-        } else if (curr->p->c1 == curr) {
-            encoding.push_back(1);
+    if (codeLengths[symbol] > MAX_CODE_LENGTH) {  // no code, walk up the tree
+        string bits;
+        for (uint16_t curr = leaves[symbol]; nodes[curr].p != HCNode::NONE;
+             curr = nodes[curr].p) {
+            bits += (nodes[nodes[curr].p].c0 == curr) ? ZERO_LITERAL
+                                                      : ONE_LITERAL;
         }
-        curr = curr->p;
+        out << string(bits.rbegin(), bits.rend());
+        return;
     }
 
-    // if no encoding, then theres only one leaf and encoding will just be 0
-    if (encoding.size() == 0) {
-        out << 0;
-    } else {  // print out encoding in reverse order
-        for (int i = encoding.size() - 1; i >= 0; i--) {
-            out << encoding[i];
-        }
+    uint64_t code = codes[symbol];
+    // print out codeword starting from its most significant bit
+    for (int i = codeLengths[symbol] - 1; i >= 0; i--) {
+        out << ((code >> i) & 1);
     }
 }
 
 /* Decodes the sequence of bits from the BitInputStream and
- * returns the coded symbol.
+ * returns the coded symbol. Looks up the next TABLE_BITS bits at once and
+ * continues in a subtable for codes longer than that.
  * @param in BitInputStream to take input bits from
  * @return byte that represents the decoded symbol of the inputted bit
  */
 byte HCTree::decode(BitInputStream& in) const {
-    HCNode* curr = root;  // stores where we are in the tree
-    unsigned int bit;     // bit we read in
-
-    while (curr) {  // read bits and traverse down the tree
-        bit = in.readBit();
-        if (bit == 0 && curr->c0) {  // go left (c0)
-            curr = curr->c0;
-        } else if (bit == 1 && curr->c1) {  // go right (c1)
-            curr = curr->c1;
+    if (decodeTable.empty()) {  // nothing to decode
+        return 0;
+    }
+
+    return lookup(in);
+}
+
+/* Builds the table used by decodeMany, which finds every whole code in the
+ * next MULTI_TABLE_BITS bits with one lookup. Each window is decoded the way
+ * lookup would, one code at a time, until the next code is longer than the
+ * bits left or MULTI_SYMBOLS codes are found. Left empty if no two codes fit in
+ * a window.
+ */
+void HCTree::buildMultiDecodeTable() {
+    static_assert(MULTI_TABLE_BITS >= TABLE_BITS,
+                  "windows must hold a first level lookup");
+    const uint32_t mask = (1 << MULTI_TABLE_BITS) - 1;
+
+    multiTable.clear();
+    if (decodeTable.empty()) {  // nothing to decode
+        return;
+    }
+
+    // with no two codes fitting in a window, one symbol per lookup is all the
+    // table could give, so decodeMany is better off without it
+    unsigned int shortest = MAX_CODE_LENGTH;
+    for (byte length : codeLengths) {
+        if (length != 0 && length < shortest) {
+            shortest = length;
         }
+    }
+    if (2 * shortest > MULTI_TABLE_BITS) {
+        return;
+    }
 
-        // return symbol if we reached end of tree
-        if (curr->c0 == nullptr && curr->c1 == nullptr) {
-            return curr->symbol;
+    multiTable.resize(1 << MULTI_TABLE_BITS);
+    for (uint32_t window = 0; window <= mask; window++) {
+        MultiDecodeEntry& entry = multiTable[window];
+        entry.count = 0;
+        unsigned int used = 0;  // bits of the window taken by found codes
+        while (entry.count < MULTI_SYMBOLS) {
+            // bits after the found codes, 0s past the end of the window
+            uint32_t rest = (window << used) & mask;
+            const DecodeEntry& next =
+                decodeTable[rest >> (MULTI_TABLE_BITS - TABLE_BITS)];
+            if (next.length == 0 || used + next.length > MULTI_TABLE_BITS) {
+                break;  // code goes on past the window
+            }
+            entry.symbols[entry.count++] = next.symbol;
+            used += next.length;
         }
+        entry.length = used;
+    }
+}
+
+/* Decodes count symbols from the BitInputStream into out. Once the
+ * multi-symbol table is built, each lookup writes the symbols of all codes
+ * that fit in its window, and codes longer than TABLE_BITS go through the
+ * decoding table.
+ * @param in BitInputStream to take input bits from
+ * @param out Where to write the decoded symbols
+ * @param count Number of symbols to decode
+ */
+void HCTree::decodeMany(BitInputStream& in, byte* out, size_t count) const {
+    if (decodeTable.empty()) {  // nothing to decode, same as decode()
+        memset(out, 0, count);
+        return;
+    }
+
+    size_t i = 0;
+    if (!multiTable.empty()) {
+        // every lookup writes MULTI_SYMBOLS bytes, only count of them kept
+        while (i + MULTI_SYMBOLS <= count) {
+            const MultiDecodeEntry& entry =
+                multiTable[in.peekBits(MULTI_TABLE_BITS)];
+            if (entry.count == 0) {  // long code, one symbol at a time
+                out[i++] = lookup(in);
+                continue;
+            }
+            memcpy(out + i, entry.symbols, MULTI_SYMBOLS);
+            in.consumeBits(entry.length);
+            i += entry.count;
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = lookup(in);
+    }
+}
+
+/* Decodes count symbols from each of INTERLEAVED_STREAMS streams. All streams
+ * advance in the same loop iteration, so the table lookups of different streams
+ * do not wait on each other.
+ * @param in BitInputStreams to take input bits from, one per stream
+ * @param out Where to write the symbols of each stream
+ * @param count Number of symbols to decode from each stream
+ */
+void HCTree::decodeInterleaved(BitInputStream* in, byte* const* out,
+                               size_t count) const {
+    if (decodeTable.empty()) {  // nothing to decode
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        byte symbol0 = lookup(in[0]);
+        byte symbol1 = lookup(in[1]);
+        byte symbol2 = lookup(in[2]);
+        byte symbol3 = lookup(in[3]);
+        out[0][i] = symbol0;  // stores last, they could alias the streams
+        out[1][i] = symbol1;
+        out[2][i] = symbol2;
+        out[3][i] = symbol3;
     }
-    return 0;
 }
 
 /* Decodes the inputted bit (0,1) from the istream and returns the coded symbol.
+ * Walks the tree, so only works after build().
  * @param in istream to take input bits from
  * @return byte that represents the decoded symbol of the inputted bit
  */
 byte HCTree::decode(istream& in) const {
-    HCNode* curr = root;  // stores where we are in the tree
-    char bit;             // bit we read in
-
-    while (curr && in.get(bit)) {  // read bits and traverse down the tree
-        if (bit == ZERO_LITERAL && curr->c0) {  // go left (c0)
-            curr = curr->c0;
-        } else if (bit == ONE_LITERAL && curr->c1) {  // go right (c1)
-            curr = curr->c1;
+    uint16_t curr = root;  // stores where we are in the tree
+    char bit;              // bit we read in
+
+    while (curr != HCNode::NONE && in.get(bit)) {  // traverse down the tree
+        if (bit == ZERO_LITERAL && nodes[curr].c0 != HCNode::NONE) {  // go c0
+            curr = nodes[curr].c0;
+        } else if (bit == ONE_LITERAL && nodes[curr].c1 != HCNode::NONE) {
+            curr = nodes[curr].c1;  // go right (c1)
         }
 
         // return symbol if we reached end of tree
-        if (curr->c0 == nullptr && curr->c1 == nullptr) {
-            return curr->symbol;
+        if (nodes[curr].isLeaf()) {
+            return nodes[curr].symbol;
         }
     }
     return 0;
@@ -236,47 +565,230 @@ vector<int> HCTree::binaryRep() const {
  * @param childrenCount Vector to store 1 or 0 for tree
  * @param curr Current node we are on
  */
-void HCTree::binaryRepRec(vector<int>& childrenCount, HCNode* curr) const {
-    // base case, curr == null, return
-    if (curr == nullptr) {
+void HCTree::binaryRepRec(vector<int>& childrenCount, uint16_t curr) const {
+    // base case, no node, return
+    if (curr == HCNode::NONE) {
         return;
     }
 
     // recursive calls for children
-    binaryRepRec(childrenCount, curr->c0);
-    binaryRepRec(childrenCount, curr->c1);
+    binaryRepRec(childrenCount, nodes[curr].c0);
+    binaryRepRec(childrenCount, nodes[curr].c1);
 
     // -1 for internal node or symbol for leaf node
-    if (curr->c0 == nullptr && curr->c1 == nullptr) {
-        childrenCount.push_back(curr->symbol);
+    if (nodes[curr].isLeaf()) {
+        childrenCount.push_back(nodes[curr].symbol);
     } else {
         childrenCount.push_back(-1);
     }
 }
 
+/* Builds the per symbol code table from the current tree. */
+void HCTree::buildCodeTable() {
+    codes.assign(codes.size(), 0);
+    codeLengths.assign(codeLengths.size(), 0);
+    if (root == HCNode::NONE) {
+        return;
+    }
+
+    // if only one leaf, its encoding will just be 0
+    if (nodes[root].isLeaf()) {
+        codeLengths[nodes[root].symbol] = 1;
+        return;
+    }
+    buildCodeTableRec(root, 0, 0);
+}
+
+/* Helper for filling the code table using recursion. Codes of leaves deeper
+ * than MAX_CODE_LENGTH do not fit and are left 0, only their lengths are kept.
+ * @param curr Current node we are on
+ * @param code Bits of the path from root to curr
+ * @param depth Depth of curr in the tree
+ */
+void HCTree::buildCodeTableRec(uint16_t curr, uint64_t code,
+                               unsigned int depth) {
+    const HCNode& node = nodes[curr];
+    if (node.isLeaf()) {  // leaf, store code if it fits
+        codes[node.symbol] = (depth <= MAX_CODE_LENGTH) ? code : 0;
+        codeLengths[node.symbol] = depth;
+        return;
+    }
+    buildCodeTableRec(node.c0, code << 1, depth + 1);
+    buildCodeTableRec(node.c1, (code << 1) | 1, depth + 1);
+}
+
+/* Assigns canonical codewords from the code lengths. Shorter codes come first
+ * and codes of the same length are ordered by symbol.
+ */
+void HCTree::assignCanonicalCodes() {
+    // count codes of each length
+    vector<uint64_t> lengthCounts(MAX_CODE_LENGTH + 1);
+    for (unsigned int i = 0; i < codeLengths.size(); i++) {
+        lengthCounts[codeLengths[i]]++;
+    }
+    lengthCounts[0] = 0;
+
+    // first codeword of each length follows the last one of previous length
+    vector<uint64_t> nextCode(MAX_CODE_LENGTH + 1);
+    uint64_t code = 0;
+    for (unsigned int len = 1; len <= MAX_CODE_LENGTH; len++) {
+        code = (code + lengthCounts[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+
+    for (unsigned int i = 0; i < codes.size(); i++) {
+        codes[i] = (codeLengths[i] == 0) ? 0 : nextCode[codeLengths[i]]++;
+    }
+}
+
+/* Builds the decoding table from the code table. Left empty if any code is
+ * longer than MAX_CODE_LENGTH. */
+void HCTree::buildDecodeTable() {
+    decodeTable.clear();
+    multiTable.clear();  // built again from the new table when needed
+
+    // gather used symbols, ordered by their codewords read left to right
+    vector<byte> symbols;
+    for (unsigned int i = 0; i < codeLengths.size(); i++) {
+        if (codeLengths[i] > MAX_CODE_LENGTH) {  // codes do not fit, no table
+            return;
+        }
+        if (codeLengths[i] != 0) {
+            symbols.push_back(i);
+        }
+    }
+    if (symbols.empty()) {
+        return;
+    }
+    sort(symbols.begin(), symbols.end(), [this](byte lhs, byte rhs) {
+        return (codes[lhs] << (MAX_CODE_LENGTH - codeLengths[lhs])) <
+               (codes[rhs] << (MAX_CODE_LENGTH - codeLengths[rhs]));
+    });
+
+    // entries no code reaches decode to 0 so broken input still makes progress
+    decodeTable.assign(1 << TABLE_BITS, DecodeEntry{0, 0, 1, 0});
+
+    // a lone symbol is encoded as a single bit, so either bit decodes to it
+    if (symbols.size() == 1) {
+        decodeTable.assign(1 << TABLE_BITS, DecodeEntry{0, symbols[0], 1, 0});
+        return;
+    }
+    buildDecodeTableRec(0, TABLE_BITS, 0, symbols.begin(), symbols.end());
+}
+
+/* Helper for filling one table of the decoding table using recursion. Every
+ * window that starts with a short enough code decodes to its symbol. Longer
+ * codes sharing the same window get a subtable of their own.
+ * @param offset Index of the first entry of the table
+ * @param width Number of bits looked up in the table
+ * @param consumed Number of code bits consumed before reaching the table
+ * @param first First symbol with a code to put in the table
+ * @param last One past the last symbol, symbols sorted by codeword
+ */
+void HCTree::buildDecodeTableRec(size_t offset, unsigned int width,
+                                 unsigned int consumed,
+                                 vector<byte>::const_iterator first,
+                                 vector<byte>::const_iterator last) {
+    const uint64_t mask = ((uint64_t)1 << width) - 1;
+    while (first != last) {
+        byte symbol = *first;
+        unsigned int left = codeLengths[symbol] - consumed;  // bits not used
+
+        if (left <= width) {  // code ends in this table, fill its range
+            uint64_t start = (codes[symbol] & ((1 << left) - 1))
+                             << (width - left);
+            for (uint64_t i = 0; i < ((uint64_t)1 << (width - left)); i++) {
+                decodeTable[offset + start + i] =
+                    DecodeEntry{0, symbol, (byte)left, 0};
+            }
+            first++;
+            continue;
+        }
+
+        // find all longer codes that share this window and their longest code
+        uint64_t index = (codes[symbol] >> (left - width)) & mask;
+        unsigned int longest = left;
+        vector<byte>::const_iterator groupEnd = first;
+        while (groupEnd != last) {
+            unsigned int groupLeft = codeLengths[*groupEnd] - consumed;
+            if (groupLeft <= width ||
+                ((codes[*groupEnd] >> (groupLeft - width)) & mask) != index) {
+                break;
+            }
+            longest = max(longest, groupLeft);
+            groupEnd++;
+        }
+
+        // subtable only as wide as the longest code needs, up to TABLE_BITS
+        unsigned int subBits = longest - width;
+        if (subBits > TABLE_BITS) {
+            subBits = TABLE_BITS;
+        }
+        size_t subOffset = decodeTable.size();
+        decodeTable.resize(subOffset + ((size_t)1 << subBits),
+                           DecodeEntry{0, 0, 1, 0});
+        decodeTable[offset + index] =
+            DecodeEntry{(uint32_t)subOffset, 0, 0, (byte)subBits};
+        buildDecodeTableRec(subOffset, subBits, consumed + width, first,
+                            groupEnd);
+        first = groupEnd;
+    }
+}
+
 /* Helper for testing root node. Returns root node.
- * @return HCNode root
+ * @return HCNode root, nullptr if the tree is empty
  */
-HCNode* HCTree::getRoot() const { return root; }
+const HCNode* HCTree::getRoot() const { return getNode(root); }
 
 /* Helper for testing leaves. Returns leaves vector.
- * @return leaves vector
+ * @return leaves vector, nullptr for symbols not in the tree
  */
-vector<HCNode*> HCTree::getLeaves() const { return leaves; }
+vector<const HCNode*> HCTree::getLeaves() const {
+    vector<const HCNode*> leafNodes(SYMBOLS);
+    for (unsigned int i = 0; i < SYMBOLS; i++) {
+        leafNodes[i] = getNode(leaves[i]);
+    }
+    return leafNodes;
+}
 
-/* Helper method for deleting all HCNodes.
- * @param node HCNode to delete subtree of and the node.
+/* Helper for testing children and parents. Returns the node at index.
+ * @param index Index of the node, such as a child index of another node
+ * @return HCNode at index, nullptr for HCNode::NONE
  */
-void HCTree::deleteHCNodes(HCNode* node) {
-    // base case
-    if (node == nullptr) {
-        return;
-    }
+const HCNode* HCTree::getNode(uint16_t index) const {
+    return (index == HCNode::NONE) ? nullptr : &nodes[index];
+}
 
-    // delete children
-    deleteHCNodes(node->c0);
-    deleteHCNodes(node->c1);
+/* Returns the code length of every symbol, 0 if the symbol is unused.
+ * @return code lengths vector
+ */
+vector<byte> HCTree::getCodeLengths() const { return codeLengths; }
 
-    // then delete this node
-    delete (node);
-}
\ No newline at end of file
+/* Forgets every code, leaving the tree as if newly constructed without
+ * releasing its tables.
+ */
+void HCTree::clear() {
+    clearNodes();
+    fill(codes.begin(), codes.end(), 0);
+    fill(codeLengths.begin(), codeLengths.end(), 0);
+    decodeTable.clear();
+    multiTable.clear();
+}
+
+/* Adds a node to the node array.
+ * @param node HCNode to add
+ * @return index of the added node
+ */
+uint16_t HCTree::addNode(const HCNode& node) {
+    nodes[nodeCount] = node;
+    return nodeCount++;
+}
+
+/* Forgets all HCNodes, leaving the tree empty. */
+void HCTree::clearNodes() {
+    nodeCount = 0;
+    root = HCNode::NONE;
+    for (unsigned int i = 0; i < SYMBOLS; i++) {
+        leaves[i] = HCNode::NONE;
+    }
+}
@@ -10,6 +10,7 @@
 #ifndef HCTREE_HPP
 #define HCTREE_HPP
 
+#include <cstdint>
 #include <fstream>
 #include <queue>
 #include <vector>
@@ -21,43 +22,163 @@ using namespace std;
 
 /** Class for HCTree that builds a Huffman coding tree using HCNodes. It builds
  * the tree using a vector of frequencies and can encode or decode symbols in
- * the tree. Includes a root HCNode*, and a leaves vector for direct access to
- * the symbols in the tree.
+ * the tree. Nodes are stored in one array inside the tree and link to each
+ * other by index, so building a tree allocates nothing. Includes the root's
+ * index, and a leaves array for direct access to the symbols in the tree.
  */
 class HCTree {
   private:
-    HCNode* root;            // the root of HCTree
-    vector<HCNode*> leaves;  // a vector storing pointers to all leaf HCNodes
+    /* Entry of the decoding table. If length is non zero, the entry decodes
+     * to symbol after consuming length bits of the window. Otherwise the code
+     * is longer than the window and decoding continues in the subtable of
+     * 2^bits entries that starts at index next.
+     */
+    struct DecodeEntry {
+        uint32_t next;  // index of subtable for codes longer than the window
+        byte symbol;    // decoded symbol if length is non zero
+        byte length;    // number of bits of the window used by the code
+        byte bits;      // number of bits looked up in the subtable
+    };
+
+    static const unsigned int TABLE_BITS = 10;  // bits looked up at once
+    static const unsigned int MULTI_TABLE_BITS = 12;  // bits looked up at
+                                                      // once by decodeMany
+    static const unsigned int MULTI_SYMBOLS = 4;  // most symbols per lookup
+    static const unsigned int LENGTH_WIDTH_BITS = 3;  // bits for length width
+    static const unsigned int ZERO_RUN_BITS = 8;  // bits for unused symbols run
+    static const unsigned int SYMBOLS = 256;      // number of byte values
+    static const unsigned int MAX_NODES = 2 * SYMBOLS - 1;  // nodes of a full
+                                                            // tree
+
+    /* Entry of the multi-symbol decoding table. The window holds count whole
+     * codes taking length bits, which decode to the first count symbols. A
+     * count of 0 means the first code is longer than TABLE_BITS.
+     */
+    struct MultiDecodeEntry {
+        byte symbols[MULTI_SYMBOLS];  // decoded symbols, first count used
+        byte count;                   // number of whole codes in the window
+        byte length;                  // number of bits used by those codes
+    };
+
+    HCNode nodes[MAX_NODES];    // all nodes of the tree
+    unsigned int nodeCount;     // number of nodes used in nodes
+    uint16_t root;              // index of the root, HCNode::NONE if empty
+    uint16_t leaves[SYMBOLS];   // index of each symbol's leaf, or HCNode::NONE
+    vector<DecodeEntry> decodeTable;  // first TABLE_BITS entries, subtables
+    vector<MultiDecodeEntry> multiTable;  // MULTI_TABLE_BITS entries, empty
+                                          // until built
+    vector<uint64_t> codes;           // codeword of each symbol, right aligned
+    vector<byte> codeLengths;         // length of each codeword, 0 if unused
+
+    /* Builds the per symbol code table from the current tree. */
+    void buildCodeTable();
+
+    /* Helper for filling the code table using recursion. Codes of leaves
+     * deeper than MAX_CODE_LENGTH do not fit and are left 0.
+     * @param curr Current node we are on
+     * @param code Bits of the path from root to curr
+     * @param depth Depth of curr in the tree
+     */
+    void buildCodeTableRec(uint16_t curr, uint64_t code, unsigned int depth);
+
+    /* Computes optimal code lengths no longer than maxCodeLength using the
+     * package-merge algorithm.
+     * @param freqs Frequency counts
+     * @param maxCodeLength Longest code length allowed
+     * @return code length of each symbol, 0 if the symbol is unused
+     */
+    static vector<byte> limitedCodeLengths(const vector<uint64_t>& freqs,
+                                           unsigned int maxCodeLength);
+
+    /* Assigns canonical codewords from the code lengths. Shorter codes come
+     * first and codes of the same length are ordered by symbol. */
+    void assignCanonicalCodes();
 
-    /* Helper method for deleting all HCNodes.
-     * @param node HCNode to delete subtree of and the node.
+    /* Builds the decoding table from the code table. Left empty if any code
+     * is longer than MAX_CODE_LENGTH. */
+    void buildDecodeTable();
+
+    /* Helper for filling one table of the decoding table using recursion.
+     * @param offset Index of the first entry of the table
+     * @param width Number of bits looked up in the table
+     * @param consumed Number of code bits consumed before reaching the table
+     * @param first First symbol with a code to put in the table
+     * @param last One past the last symbol, symbols sorted by codeword
+     */
+    void buildDecodeTableRec(size_t offset, unsigned int width,
+                             unsigned int consumed,
+                             vector<byte>::const_iterator first,
+                             vector<byte>::const_iterator last);
+
+    /* Looks the next code of the BitInputStream up in the decoding table and
+     * consumes it. Inline so decoding loops keep it in registers.
+     * @param in BitInputStream to take input bits from
+     * @return byte that represents the decoded symbol
+     */
+    byte lookup(BitInputStream& in) const {
+        unsigned int width = TABLE_BITS;  // bits looked up in current table
+        const DecodeEntry* entry = &decodeTable[in.peekBits(width)];
+        while (entry->length == 0) {  // code is longer, move on to subtable
+            in.consumeBits(width);
+            width = entry->bits;
+            entry = &decodeTable[entry->next + in.peekBits(width)];
+        }
+        in.consumeBits(entry->length);
+        return entry->symbol;
+    }
+
+    /* Sorts the leaves from highest to lowest priority.
+     * @param sorted Where to store the indices of the leaves
+     * @return number of leaves
      */
-    void deleteHCNodes(HCNode* node);
+    unsigned int sortLeaves(uint16_t* sorted) const;
+
+    /* Adds a node to the node array.
+     * @param node HCNode to add
+     * @return index of the added node
+     */
+    uint16_t addNode(const HCNode& node);
+
+    /* Forgets all HCNodes, leaving the tree empty. */
+    void clearNodes();
 
     /* Helper for creating header of tree using recursion.
      * @param childrenCount Vector to store 1 or 0 for tree
      * @param curr Current node we are on
      */
-    void binaryRepRec(vector<int>& childrenCount, HCNode* curr) const;
+    void binaryRepRec(vector<int>& childrenCount, uint16_t curr) const;
 
   public:
+    static const unsigned int INTERLEAVED_STREAMS = 4;  // decodeInterleaved
+    static const unsigned int MAX_CODE_LENGTH = 64;      // longest codeword
+    static const unsigned int MAX_HEADER_BITS =  // longest code length header
+        LENGTH_WIDTH_BITS +
+        SYMBOLS * ((1 << LENGTH_WIDTH_BITS) - 1 + ZERO_RUN_BITS);
+
     /* Explicit Constructor.
      * Initializes an empty HCTree */
     HCTree() {
-        root = nullptr;
-        leaves = vector<HCNode*>(256);
+        clearNodes();
+        codes = vector<uint64_t>(SYMBOLS);
+        codeLengths = vector<byte>(SYMBOLS);
     }
 
-    /* Deconstructor.
-     * Deallocates the memory of the HCTree and all the HCNodes inside of it.
-     */
-    ~HCTree();
+    /* Ways of ordering merged nodes of equal count while building */
+    enum TieBreak {
+        SYMBOL_ORDER,  // higher symbol first, same tree as a priority queue
+        QUEUE_ORDER    // in the order they were merged, strictly linear time
+    };
 
     /* Builds the HCTree from a given frequency vector. Only non-zero
-     * frequencies go in the tree.
+     * frequencies go in the tree. Takes linear time after sorting the leaves.
+     * Both ways of breaking ties give optimal codes, but only SYMBOL_ORDER
+     * gives the tree files have always been written with.
+     * A tree deeper than MAX_CODE_LENGTH gets no codes or decoding table, so
+     * it only encodes and decodes as 0 and 1 characters.
      * @param freqs Frequency counts
+     * @param ties How merged nodes of equal count are ordered
      */
-    void build(const vector<unsigned int>& freqs);
+    void build(const vector<uint64_t>& freqs, TieBreak ties = SYMBOL_ORDER);
 
     /* Builds the HCTree by reading in bit by bit.
      * @param inBit BitInputStream to read from
@@ -65,7 +186,39 @@ class HCTree {
      */
     void buildWithHeader(BitInputStream& inBit, unsigned int nonZeros);
 
+    /* Builds canonical codes for the given frequency vector. Code lengths come
+     * from the Huffman tree, which is not kept afterwards. If the tree is
+     * deeper than maxCodeLength, optimal lengths within the limit are used
+     * instead. The limit is raised if too small to give every used symbol a
+     * code.
+     * @param freqs Frequency counts
+     * @param maxCodeLength Longest code length allowed, 0 for MAX_CODE_LENGTH
+     */
+    void buildCanonical(const vector<uint64_t>& freqs,
+                        unsigned int maxCodeLength = 0);
+
+    /* Builds canonical codes from the code length of every symbol. No HCNodes
+     * are created. Symbols missing from lengths are unused, lengths past the
+     * last byte value are ignored and lengths above MAX_CODE_LENGTH are cut
+     * down to it.
+     * @param lengths Code length of each symbol, 0 if the symbol is unused
+     */
+    void buildWithCodeLengths(const vector<byte>& lengths);
+
+    /* Builds canonical codes from a code length header.
+     * @param inBit BitInputStream to read the header from
+     */
+    void buildWithCodeLengths(BitInputStream& inBit);
+
+    /* Writes the code lengths of all symbols as header. Writes how many bits
+     * each length takes, then the lengths in symbol order where a length of 0
+     * is followed by how many more unused symbols come after it.
+     * @param outBit BitOutputStream to write the header to
+     */
+    void writeCodeLengths(BitOutputStream& outBit) const;
+
     /* Writes the encoding bits of given symbol to given BitOutputStream.
+     * Looks the codeword up in the code table computed when building.
      * @param symbol to encode into bits and to write to BitOutputStream
      * @param out BitOutputStream to write encoded bit to
      */
@@ -78,14 +231,42 @@ class HCTree {
     void encode(byte symbol, ostream& out) const;
 
     /* Decodes the sequence of bits from the BitInputStream and
-     * returns the coded symbol.
+     * returns the coded symbol. Looks up the next TABLE_BITS bits at once and
+     * continues in a subtable for codes longer than that.
      * @param in BitInputStream to take input bits from
      * @return byte that represents the decoded symbol of the inputted bit
      */
     byte decode(BitInputStream& in) const;
 
+    /* Builds the table used by decodeMany, which finds every whole code in
+     * the next MULTI_TABLE_BITS bits with one lookup. Kept apart from building
+     * the codes, since only long runs of decoding pay back its cost. Left
+     * empty if no two codes fit in a window.
+     */
+    void buildMultiDecodeTable();
+
+    /* Decodes count symbols from the BitInputStream into out. Once the
+     * multi-symbol table is built, each lookup writes the symbols of all
+     * codes that fit in its window, and codes longer than TABLE_BITS go
+     * through the decoding table.
+     * @param in BitInputStream to take input bits from
+     * @param out Where to write the decoded symbols
+     * @param count Number of symbols to decode
+     */
+    void decodeMany(BitInputStream& in, byte* out, size_t count) const;
+
+    /* Decodes count symbols from each of INTERLEAVED_STREAMS streams. All
+     * streams advance in the same loop iteration, so the table lookups of
+     * different streams do not wait on each other.
+     * @param in BitInputStreams to take input bits from, one per stream
+     * @param out Where to write the symbols of each stream
+     * @param count Number of symbols to decode from each stream
+     */
+    void decodeInterleaved(BitInputStream* in, byte* const* out,
+                           size_t count) const;
+
     /* Decodes the inputted bit (0,1) from the istream and returns the coded
-     * symbol.
+     * symbol. Walks the tree, so only works after build().
      * @param in istream to take input bits from
      * @return byte that represents the decoded symbol of the inputted bit
      */
@@ -98,14 +279,37 @@ class HCTree {
     vector<int> binaryRep() const;
 
     /* Helper for testing root node. Returns root node.
-     * @return HCNode root
+     * @return HCNode root, nullptr if the tree is empty
      */
-    HCNode* getRoot() const;
+    const HCNode* getRoot() const;
 
     /* Helper for testing leaves. Returns leaves vector.
-     * @return leaves vector
+     * @return leaves vector, nullptr for symbols not in the tree
+     */
+    vector<const HCNode*> getLeaves() const;
+
+    /* Helper for testing children and parents. Returns the node at index.
+     * @param index Index of the node, such as a child index of another node
+     * @return HCNode at index, nullptr for HCNode::NONE
+     */
+    const HCNode* getNode(uint16_t index) const;
+
+    /* Returns the code length of every symbol, 0 if the symbol is unused.
+     * @return code lengths vector
+     */
+    vector<byte> getCodeLengths() const;
+
+    /* Forgets every code, leaving the tree as if newly constructed without
+     * releasing its tables.
+     */
+    void clear();
+
+  private:
+    /* Builds only the nodes of the Huffman tree, without any codes.
+     * @param freqs Frequency counts
+     * @param ties How merged nodes of equal count are ordered
      */
-    vector<HCNode*> getLeaves() const;
+    void buildTree(const vector<uint64_t>& freqs, TieBreak ties = SYMBOL_ORDER);
 };
 
 #endif  // HCTREE_HPP
@@ -0,0 +1,143 @@
+/**
+ * Counts how often each byte value appears in a block of memory. Large inputs
+ * can be split into chunks that are counted on several threads.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#include "Histogram.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#define ASCII_MAX 256  // number of byte values to count
+
+/* Adds the count of each byte value in data to freqs.
+ * @param data First byte to count
+ * @param size Number of bytes to count
+ * @param freqs Frequency vector of 256 counts to add to
+ * @param kernel Way of counting the bytes
+ */
+void Histogram::count(const byte* data, size_t size,
+                      vector<uint64_t>& freqs, Kernel kernel) {
+    if (kernel == SIMPLE) {
+        countSimple(data, size, freqs);
+    } else {
+        countInterleaved(data, size, freqs);
+    }
+}
+
+/* Adds the count of each byte value in data to freqs one byte at a time. Runs
+ * of the same byte make each increment wait for the previous one.
+ * @param data First byte to count
+ * @param size Number of bytes to count
+ * @param freqs Frequency vector of 256 counts to add to
+ */
+void Histogram::countSimple(const byte* data, size_t size,
+                            vector<uint64_t>& freqs) {
+    for (size_t i = 0; i < size; i++) {
+        freqs[data[i]]++;
+    }
+}
+
+/* Adds the count of each byte value in data to freqs. Reads a word at a time
+ * and counts neighbouring bytes in different tables, so repeated bytes do not
+ * all wait on the same counter. The tables are 32 bit, so data of 4 GiB or
+ * more is counted a span at a time.
+ * @param data First byte to count
+ * @param size Number of bytes to count
+ * @param freqs Frequency vector of 256 counts to add to
+ */
+void Histogram::countInterleaved(const byte* data, size_t size,
+                                 vector<uint64_t>& freqs) {
+    while (size > MAX_TABLE_SPAN) {
+        countInterleaved(data, MAX_TABLE_SPAN, freqs);
+        data += MAX_TABLE_SPAN;
+        size -= MAX_TABLE_SPAN;
+    }
+
+    uint32_t tables[TABLES][ASCII_MAX] = {};
+    const size_t step = 2 * sizeof(uint32_t);  // bytes counted per iteration
+
+    size_t i = 0;
+    for (; i + step <= size; i += step) {
+        uint32_t first, second;
+        memcpy(&first, data + i, sizeof(first));
+        memcpy(&second, data + i + sizeof(first), sizeof(second));
+
+        tables[0][first & 0xFF]++;
+        tables[1][(first >> 8) & 0xFF]++;
+        tables[2][(first >> 16) & 0xFF]++;
+        tables[3][first >> 24]++;
+        tables[0][second & 0xFF]++;
+        tables[1][(second >> 8) & 0xFF]++;
+        tables[2][(second >> 16) & 0xFF]++;
+        tables[3][second >> 24]++;
+    }
+    for (; i < size; i++) {  // bytes after the last whole step
+        tables[0][data[i]]++;
+    }
+
+    for (unsigned int j = 0; j < ASCII_MAX; j++) {
+        freqs[j] += tables[0][j] + tables[1][j] + tables[2][j] + tables[3][j];
+    }
+}
+
+/* Adds the count of each byte value in data to freqs, splitting data into one
+ * chunk per thread and merging the counts of each chunk at the end. Uses fewer
+ * threads if the chunks would be too small to be worth it, so a block of the
+ * default size is split in at most 4 chunks.
+ * @param data First byte to count
+ * @param size Number of bytes to count
+ * @param freqs Frequency vector of 256 counts to add to
+ * @param threads Number of threads to count with
+ * @param kernel Way of counting each chunk
+ */
+void Histogram::countParallel(const byte* data, size_t size,
+                              vector<uint64_t>& freqs, unsigned int threads,
+                              Kernel kernel) {
+    size_t chunks = size / MIN_CHUNK_SIZE;
+    if (chunks > threads) {
+        chunks = threads;
+    }
+    if (chunks <= 1) {  // not worth starting any thread
+        count(data, size, freqs, kernel);
+        return;
+    }
+
+    // each chunk gets counted into its own frequency vector
+    vector<vector<uint64_t>> partials(chunks, vector<uint64_t>(ASCII_MAX));
+    vector<thread> workers;
+    size_t chunkSize = size / chunks;
+    for (size_t i = 0; i < chunks; i++) {
+        size_t start = i * chunkSize;
+        size_t end = (i == chunks - 1) ? size : start + chunkSize;
+        workers.emplace_back(count, data + start, end - start,
+                             ref(partials[i]), kernel);
+    }
+
+    // wait for each chunk and merge its counts
+    for (size_t i = 0; i < chunks; i++) {
+        workers[i].join();
+        for (unsigned int j = 0; j < ASCII_MAX; j++) {
+            freqs[j] += partials[i][j];
+        }
+    }
+}
+
+/* Adds the count of each pair of a byte value and the byte before it to freqs,
+ * at index previous * 256 + symbol. The first byte counts as following a 0.
+ * @param data First byte to count
+ * @param size Number of bytes to count
+ * @param freqs Frequency vector of 256 * 256 counts to add to
+ */
+void Histogram::countContexts(const byte* data, size_t size,
+                              vector<uint64_t>& freqs) {
+    byte previous = 0;
+    for (size_t i = 0; i < size; i++) {
+        freqs[previous * ASCII_MAX + data[i]]++;
+        previous = data[i];
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * Counts how often each byte value appears in a block of memory. Large inputs
+ * can be split into chunks that are counted on several threads.
+ *
+ * Author: Aimee T Shao
+ * PID: A15444996
+ */
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Class for Histogram that fills the frequency vector used to build an
+ *  HCTree from the bytes of an input.
+ */
+class Histogram {
+  private:
+    static const size_t MIN_CHUNK_SIZE = 1 << 18;  // smallest chunk per thread
+    static const unsigned int TABLES = 4;  // count tables of interleaved kernel
+    static const size_t MAX_TABLE_SPAN = UINT32_MAX;  // most bytes counted in
+                                                      // 32 bit tables at once
+
+  public:
+    /* Ways of counting a chunk of bytes */
+    enum Kernel {
+        SIMPLE,      // one increment of freqs per byte
+        INTERLEAVED  // spreads bytes over several tables, merged at the end
+    };
+
+    /* Adds the count of each byte value in data to freqs.
+     * @param data First byte to count
+     * @param size Number of bytes to count
+     * @param freqs Frequency vector of 256 counts to add to
+     * @param kernel Way of counting the bytes
+     */
+    static void count(const byte* data, size_t size,
+                      vector<uint64_t>& freqs, Kernel kernel = INTERLEAVED);
+
+    /* Adds the count of each byte value in data to freqs one byte at a time.
+     * Runs of the same byte make each increment wait for the previous one.
+     * @param data First byte to count
+     * @param size Number of bytes to count
+     * @param freqs Frequency vector of 256 counts to add to
+     */
+    static void countSimple(const byte* data, size_t size,
+                            vector<uint64_t>& freqs);
+
+    /* Adds the count of each byte value in data to freqs. Reads a word at a
+     * time and counts neighbouring bytes in different tables, so repeated
+     * bytes do not all wait on the same counter.
+     * @param data First byte to count
+     * @param size Number of bytes to count
+     * @param freqs Frequency vector of 256 counts to add to
+     */
+    static void countInterleaved(const byte* data, size_t size,
+                                 vector<uint64_t>& freqs);
+
+    /* Adds the count of each byte value in data to freqs, splitting data into
+     * one chunk per thread and merging the counts of each chunk at the end.
+     * Uses fewer threads if the chunks would be too small to be worth it, so
+     * a block of the default size is split in at most 4 chunks.
+     * @param data First byte to count
+     * @param size Number of bytes to count
+     * @param freqs Frequency vector of 256 counts to add to
+     * @param threads Number of threads to count with
+     * @param kernel Way of counting each chunk
+     */
+    static void countParallel(const byte* data, size_t size,
+                              vector<uint64_t>& freqs,
+                              unsigned int threads,
+                              Kernel kernel = INTERLEAVED);
+
+    /* Adds the count of each pair of a byte value and the byte before it to
+     * freqs, at index previous * 256 + symbol. The first byte counts as
+     * following a 0.
+     * @param data First byte to count
+     * @param size Number of bytes to count
+     * @param freqs Frequency vector of 256 * 256 counts to add to
+     */
+    static void countContexts(const byte* data, size_t size,
+                              vector<uint64_t>& freqs);
+};
+
+#endif  // HISTOGRAM_HPP
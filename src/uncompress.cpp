@@ -6,19 +6,28 @@
  * Author: Aimee T Shao
  * PID: A15444996
  */
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include "../subprojects/cxxopts/cxxopts.hpp"
+#include "AdaptiveCodec.hpp"
+#include "BlockCodec.hpp"
 #include "FileUtils.hpp"
 #include "HCNode.hpp"
 #include "HCTree.hpp"
+#include "Histogram.hpp"
+#include "MappedFile.hpp"
 
-#define TOTAL_SYMBOLS_BITS 32  // # of bits to represent total symbols
-#define NON_ZEROS_BITS 9       // # of bits to represent nonZeros
-#define BIT_IN_BYTE 8          // used for output symbol
-#define BINARY 2               // binary is base 2
-#define ASCII_MAX 256          // number of ascii values for HCTree
+#define SINGLE_STREAM_VERSION 1  // one canonical code for the whole file
+#define TOTAL_SYMBOLS_BITS 32    // # of bits to represent total symbols
+#define NON_ZEROS_BITS 9         // # of bits to represent nonZeros
+#define ASCII_MAX 256            // number of ascii values for HCTree
+#define OUT_BUFFER_SIZE (1 << 16)  // bytes decoded before each write
 
 /* Perform pseudo decompression with ascii encoding and naive header
  * (checkpoint) Read compressed file, build HCTree based header, open
@@ -27,23 +36,24 @@
  * @param outFileName File to write uncompressed file to
  */
 void pseudoDecompression(string inFileName, string outFileName) {
-    ifstream in(inFileName, ios::binary);  // open inFile
+    ifstream inFile;
+    istream& in = FileUtils::openInput(inFileName, inFile);  // open inFile
 
-    HCTree tree;                            // HCTree to build and help decode
-    vector<unsigned int> freqs(ASCII_MAX);  // stores freqs from input file
+    HCTree tree;                        // HCTree to build and help decode
+    vector<uint64_t> freqs(ASCII_MAX);  // stores freqs from input file
 
     char buf[BUFSIZ];        // Retrieve frequency of ascii values
     unsigned int index = 0;  // stores ascii value of char's freq we are reading
 
     while (index < ASCII_MAX) {  // get freq count for each ascii char
         in.getline(buf, BUFSIZ);
-        unsigned int count = atoi(buf);  // convert buf to unsigned int for freq
+        uint64_t count = strtoull(buf, nullptr, 10);  // convert buf to freq
         freqs[index] = count;
         index++;
     }
 
-    unsigned int totalSymbols = 0;  // stores total symbols in file
-    unsigned int symbolsRead = 0;   // how many symbols we read so far
+    uint64_t totalSymbols = 0;  // stores total symbols in file
+    uint64_t symbolsRead = 0;   // how many symbols we read so far
 
     for (unsigned int i = 0; i < freqs.size(); i++) {  // gets totalSymbols
         totalSymbols += freqs[i];
@@ -51,7 +61,8 @@ void pseudoDecompression(string inFileName, string outFileName) {
 
     tree.build(freqs);  // build tree
 
-    ofstream out(outFileName, ios::binary);  // open outFile
+    ofstream outFile;
+    ostream& out = FileUtils::openOutput(outFileName, outFile);  // open outFile
 
     while (symbolsRead < totalSymbols) {  // outputs decoding for all symbols
         out << tree.decode(in);           // output decoded char
@@ -59,46 +70,244 @@ void pseudoDecompression(string inFileName, string outFileName) {
     }
 
     // close files
-    in.close();
-    out.close();
+    out.flush();
 }
 
-/* True decompression with bitwise i/o and small header (final)
+/* Decompresses a block container with an index using several threads. Each
+ * block is decoded on its own and written straight to its place in outFile.
  * @param inFileName Compressed file to read from
  * @param outFileName File to write uncompressed file to
+ * @param threads Number of threads to decode with
+ * @param stats Where to time phases, nullptr for none
+ * @return false if the file has no index, leaving outFile alone
  */
-void trueDecompression(string inFileName, string outFileName) {
-    ifstream in(inFileName, ios::binary);  // open inFile
-    BitInputStream inBit(in);              // Bit input stream
+bool parallelDecompression(string inFileName, string outFileName,
+                           unsigned int threads, Stats* stats) {
+    Stats::Timer probe(stats, Stats::PROBE);
+    MappedFile in(inFileName);  // map inFile, blocks are read in place
+    vector<BlockCodec::BlockEntry> blocks;  // read once, handed to the pool
+    BlockCodec::Header header;
+    if (!BlockCodec::readIndex(in.data(), in.size(), blocks, header)) {
+        return false;
+    }
+
+    int out = open(outFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        cerr << "Could not open " << outFileName << ".\n";
+        return true;
+    }
+    probe.stop();
+    if (!BlockCodec::decompressParallel(in.data(), blocks, header, out, threads,
+                                        stats)) {
+        cerr << "Invalid compressed file.\n";
+    }
+    Stats::Timer flush(stats, Stats::FLUSH);
+    close(out);
+    flush.stop();
+    if (stats != nullptr) {
+        stats->finish(in.size());
+    }
+    return true;
+}
 
-    HCTree tree;                    // HCTree to build and help decode
-    unsigned int totalSymbols = 0;  // stores total number of symbols to read
-    unsigned int nonZeros = 0;      // stores nonZeros from header
-    unsigned int symbolCount = 0;   // number of symbols read
+/* Decompresses only part of the input from a block container with an index.
+ * @param inFileName Compressed file to read from
+ * @param outFileName File to write the uncompressed bytes to
+ * @param start Offset in the input of the first byte to write
+ * @param length Number of bytes to write, fewer if the input ends
+ */
+void rangeDecompression(string inFileName, string outFileName, uint64_t start,
+                        uint64_t length) {
+    MappedFile in(inFileName);  // map inFile, only the range's blocks are read
 
-    for (int i = 0; i < TOTAL_SYMBOLS_BITS; i++) {  // gets totalSymbols
-        totalSymbols *= BINARY;
-        totalSymbols += inBit.readBit();
+    ofstream outFile;
+    ostream& out = FileUtils::openOutput(outFileName, outFile);  // open outFile
+    if (!BlockCodec::decompressRange(in.data(), in.size(), start, length,
+                                     out)) {
+        cerr << "Range needs a valid compressed file with an index.\n";
     }
+    out.flush();
+}
 
-    for (int i = 0; i < NON_ZEROS_BITS; i++) {  // converts binary to nonZeros
-        nonZeros *= BINARY;
-        nonZeros += inBit.readBit();
+/* Parses a range given as START:LEN.
+ * @param range String to parse
+ * @param start Set to the offset before the colon
+ * @param length Set to the length after the colon
+ * @return false if range is not two numbers separated by a colon
+ */
+bool parseRange(const string& range, uint64_t& start, uint64_t& length) {
+    size_t colon = range.find(':');
+    if (colon == string::npos) {
+        return false;
     }
+    string startText = range.substr(0, colon);
+    string lengthText = range.substr(colon + 1);
+    if (startText.empty() || lengthText.empty() ||
+        startText.find_first_not_of("0123456789") != string::npos ||
+        lengthText.find_first_not_of("0123456789") != string::npos) {
+        return false;
+    }
+    try {
+        start = stoull(startText);
+        length = stoull(lengthText);
+    } catch (const out_of_range&) {
+        return false;
+    }
+    return true;
+}
+
+/* Writes all of a buffer to a file descriptor, write may write less.
+ * @param fd File descriptor to write to
+ * @param data First byte to write
+ * @param size Number of bytes to write
+ * @return false if writing failed
+ */
+bool writeAll(int fd, const byte* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = write(fd, data, size);
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+/* True decompression with bitwise i/o and small header (final). Reads files
+ * starting with the format magic, whether block container, single pass or one
+ * code for the whole file, and also older files without it whose header is
+ * totalSymbols, nonZeros and the post order tree.
+ * @param inFileName Compressed file to read from
+ * @param outFileName File to write uncompressed file to
+ * @param stats Where to time phases, nullptr for none
+ */
+void trueDecompression(string inFileName, string outFileName, Stats* stats) {
+    Stats::Timer probe(stats, Stats::PROBE);
+    ifstream inFile;
+    istream& in = FileUtils::openInput(inFileName, inFile);  // open inFile
+    BitInputStream inBit(in);  // Bit input stream
+
+    HCTree tree;                // HCTree to build and help decode
+    uint64_t totalSymbols = 0;  // stores total number of symbols to read
+    unsigned int nonZeros = 0;  // stores nonZeros from header
+    uint64_t symbolCount = 0;   // number of symbols read
 
-    tree.buildWithHeader(inBit, nonZeros);   // rebuild tree with rest of header
-    ofstream out(outFileName, ios::binary);  // open outFile
+    // files without the magic start right away with totalSymbols. Such a file
+    // would have to hold almost 4 GiB of symbols for the two to be confused.
+    unsigned int magic = inBit.readBits(BlockCodec::MAGIC_BITS);
+    if (magic == BlockCodec::MAGIC) {
+        unsigned int version = inBit.readBits(BlockCodec::VERSION_BITS);
+        if (version == BlockCodec::VERSION) {  // block container
+            ofstream outFile;
+            ostream& out = FileUtils::openOutput(outFileName, outFile);
+            probe.stop();
+            if (!BlockCodec::decompress(inBit, out, stats)) {
+                cerr << "Invalid compressed file.\n";
+            }
+            Stats::Timer flush(stats, Stats::FLUSH);
+            out.flush();
+            flush.stop();
+            if (stats != nullptr) {
+                stats->finish(inBit.getBytesRead());
+            }
+            return;
+        } else if (version == AdaptiveCodec::VERSION) {  // single pass
+            ofstream outFile;
+            ostream& out = FileUtils::openOutput(outFileName, outFile);
+            probe.stop();
+            Stats::Timer code(stats, Stats::CODE);  // symbols are not counted
+            if (!AdaptiveCodec::decompress(inBit, out)) {
+                cerr << "Invalid compressed file.\n";
+            }
+            code.stop();
+            Stats::Timer flush(stats, Stats::FLUSH);
+            out.flush();
+            flush.stop();
+            if (stats != nullptr) {
+                stats->finish(inBit.getBytesRead());
+            }
+            return;
+        } else if (version != SINGLE_STREAM_VERSION) {
+            cerr << "Unsupported compressed file version " << version
+                 << ".\n";
+            return;
+        }
+        probe.stop();
+        Stats::Timer build(stats, Stats::BUILD);
+        totalSymbols = inBit.readBits(TOTAL_SYMBOLS_BITS);
+        tree.buildWithCodeLengths(inBit);  // rebuild codes with rest of header
+    } else {
+        probe.stop();
+        Stats::Timer build(stats, Stats::BUILD);
+        totalSymbols = magic;                       // gets totalSymbols
+        nonZeros = inBit.readBits(NON_ZEROS_BITS);  // gets nonZeros
+        tree.buildWithHeader(inBit, nonZeros);  // rebuild tree with header
+    }
+    // the output size is known, so a file gets all of its room up front
+    bool toStdout = FileUtils::isStdStream(outFileName);
+    int out = toStdout ? STDOUT_FILENO
+                       : open(outFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                              0644);
+    if (out < 0) {
+        cerr << "Could not open " << outFileName << ".\n";
+        return;
+    }
+    if (!toStdout && totalSymbols != 0) {
+        posix_fallocate(out, 0, totalSymbols);  // only a hint, may fail
+    }
 
-    unsigned char decoding;
-    while (symbolCount < totalSymbols) {  // decode until we read all symbols
-        decoding = tree.decode(inBit);
-        out << decoding;  // output decoded char
-        symbolCount++;
+    Stats::Timer code(stats, Stats::CODE);
+    tree.buildMultiDecodeTable();
+    vector<uint64_t> freqs(ASCII_MAX);  // counted only for stats
+    vector<byte> buffer(min<uint64_t>(totalSymbols, OUT_BUFFER_SIZE));
+    while (symbolCount < totalSymbols) {  // decode a buffer at a time
+        size_t count = min<uint64_t>(buffer.size(), totalSymbols - symbolCount);
+        tree.decodeMany(inBit, buffer.data(), count);
+        if (stats != nullptr) {
+            Histogram::count(buffer.data(), count, freqs);
+        }
+        if (!writeAll(out, buffer.data(), count)) {
+            cerr << "Could not write " << outFileName << ".\n";
+            break;
+        }
+        symbolCount += count;
     }
+    code.stop();
 
     // close files
-    in.close();
-    out.close();
+    Stats::Timer flush(stats, Stats::FLUSH);
+    if (!toStdout) {
+        close(out);
+    }
+    flush.stop();
+    if (stats != nullptr) {
+        stats->addBlock(freqs, tree.getCodeLengths());
+        stats->finish(inBit.getBytesRead());
+    }
+}
+
+/* Reports the phase times and sizes collected while decompressing.
+ * @param stats Stats collected
+ * @param statsFile File to write the report to as JSON, empty for a table on
+ * stderr
+ * @param outFileName File the uncompressed bytes went to, JSON meant for stdout goes
+ * to stderr when they went there too
+ */
+void reportStats(const Stats& stats, string statsFile, string outFileName) {
+    if (statsFile.empty()) {
+        stats.print(cerr);
+        return;
+    }
+    if (statsFile == "-" && outFileName == "-") {  // keep stdout just the data
+        stats.writeJson(cerr);
+        cerr.flush();
+        return;
+    }
+    ofstream jsonFile;
+    ostream& json = FileUtils::openOutput(statsFile, jsonFile);
+    stats.writeJson(json);
+    json.flush();
 }
 
 /* Main program that runs the uncompress. Checks if input file is invalid or
@@ -107,17 +316,31 @@ void trueDecompression(string inFileName, string outFileName) {
  * @param argv Array of arguments
  */
 int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);  // stdin and stdout are only used as streams
+
     // option parsing for command line
     cxxopts::Options options("./uncompress",
                              "Uncompresses files using Huffman Encoding");
     options.positional_help(
-        "./path_to_compressed_input_file ./path_to_output_file");
+        "./path_to_compressed_input_file ./path_to_output_file (- for stdin or "
+        "stdout)");
 
     bool isAsciiOutput = false;
+    unsigned int threads = 1;
+    string range;
+    string statsFile;
     string inFileName, outFileName;
     options.allow_unrecognised_options().add_options()(
         "ascii", "Write output in ascii mode instead of bit stream",
         cxxopts::value<bool>(isAsciiOutput))(
+        "threads", "Number of threads to use (0 for one per core)",
+        cxxopts::value<unsigned int>(threads), "N")(
+        "range", "Only write LEN bytes of the input starting at byte START",
+        cxxopts::value<string>(range), "START:LEN")(
+        "stats",
+        "Report time of each phase and sizes, as JSON with =FILE (- for "
+        "stdout, stderr if the output is stdout)",
+        cxxopts::value<string>(statsFile)->implicit_value(""), "FILE")(
         "input", "", cxxopts::value<string>(inFileName))(
         "output", "", cxxopts::value<string>(outFileName))(
         "h,help", "Print help and exit");
@@ -125,8 +348,10 @@ int main(int argc, char* argv[]) {
     options.parse_positional({"input", "output"});
     auto userOptions = options.parse(argc, argv);
 
+    uint64_t rangeStart = 0, rangeLength = 0;
     if (userOptions.count("help") || !FileUtils::isValidFile(inFileName) ||
-        outFileName.empty()) {
+        outFileName.empty() ||
+        (!range.empty() && !parseRange(range, rangeStart, rangeLength))) {
         cout << options.help({""}) << std::endl;
         exit(0);
     }
@@ -137,16 +362,32 @@ int main(int argc, char* argv[]) {
     if (!utils.isValidFile(inFileName)) {  // invalid file
         return 0;
     } else if (utils.isEmptyFile(inFileName)) {  // empty file, create empty out
-        ofstream out(outFileName, ios::binary);  // open outFile
-        out.close();                             // close outFile
+        ofstream out;
+        FileUtils::openOutput(outFileName, out);  // open outFile
         return 0;
     }
 
-    // No error, then compress
+    if (threads == 0) {  // one thread per core
+        threads = max(thread::hardware_concurrency(), 1u);
+    }
+
+    // No error, then decompress
+    Stats stats;  // starts timing the whole decompression
+    Stats* timed = userOptions.count("stats") ? &stats : nullptr;
     if (isAsciiOutput) {
         pseudoDecompression(inFileName, outFileName);
-    } else {
-        trueDecompression(inFileName, outFileName);
+        timed = nullptr;  // nothing to report in ascii mode
+    } else if (!range.empty()) {
+        rangeDecompression(inFileName, outFileName, rangeStart, rangeLength);
+        timed = nullptr;  // nor for a range
+    } else if (threads <= 1 || FileUtils::isStdStream(inFileName) ||
+               FileUtils::isStdStream(outFileName) ||
+               !parallelDecompression(inFileName, outFileName, threads,
+                                      timed)) {
+        trueDecompression(inFileName, outFileName, timed);  // in order
+    }
+    if (timed != nullptr) {
+        reportStats(stats, statsFile, outFileName);
     }
 
     return 0;
@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "AdaptiveCodec.hpp"
+#include "AdaptiveHCTree.hpp"
+#include "BlockCodec.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encodes data with one tree and decodes it with another, checking both trees
+ * after every symbol.
+ * @param data Symbols to code
+ */
+void roundTrip(const vector<byte>& data) {
+    AdaptiveHCTree encoder;
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    for (byte symbol : data) {
+        encoder.encode(symbol, bos);
+        ASSERT_TRUE(encoder.isConsistent());
+    }
+    bos.flush();
+
+    AdaptiveHCTree decoder;
+    BitInputStream bis(bytes.data(), bytes.size());
+    for (byte symbol : data) {
+        ASSERT_EQ(decoder.decode(bis), symbol);
+        ASSERT_TRUE(decoder.isConsistent());
+    }
+}
+
+TEST(AdaptiveHCTreeTests, TEXT_TEST) {
+    string text = "abracadabra, the quick brown fox jumps over the lazy dog";
+    roundTrip(vector<byte>(text.begin(), text.end()));
+}
+
+TEST(AdaptiveHCTreeTests, ALL_SYMBOLS_TEST) {
+    // every byte value, then skewed so the tree keeps reshaping
+    vector<byte> data;
+    for (unsigned int i = 0; i < 256; i++) {
+        data.push_back(i);
+    }
+    srand(100);
+    for (unsigned int i = 0; i < 20000; i++) {
+        data.push_back((rand() % 256) * (rand() % 256) / 256);
+    }
+    roundTrip(data);
+}
+
+TEST(AdaptiveHCTreeTests, SINGLE_SYMBOL_TEST) {
+    AdaptiveHCTree tree;
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    for (unsigned int i = 0; i < 800; i++) {
+        tree.encode('a', bos);
+    }
+    bos.flush();
+
+    // Assert the first 'a' takes 8 bits and every other one 1 bit
+    ASSERT_EQ(bytes.size(), 101);
+    ASSERT_TRUE(tree.isConsistent());
+}
+
+TEST(AdaptiveHCTreeTests, CODEC_ROUND_TRIP_TEST) {
+    // more than one chunk, so the tree carries over between chunks
+    string text;
+    for (int i = 0; i < 3000; i++) {
+        text += "the quick brown fox jumps over the lazy dog ";
+    }
+    istringstream is(text);
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    AdaptiveCodec::compress(is, bos);
+    bos.flush();
+
+    BitInputStream bis(compressed.data(), compressed.size());
+    ASSERT_EQ(bis.readBits(BlockCodec::MAGIC_BITS), BlockCodec::MAGIC);
+    ASSERT_EQ(bis.readBits(BlockCodec::VERSION_BITS), AdaptiveCodec::VERSION);
+    ostringstream os;
+    // Assert every chunk decodes back to the original text
+    ASSERT_TRUE(AdaptiveCodec::decompress(bis, os));
+    ASSERT_EQ(os.str(), text);
+}
@@ -34,4 +34,80 @@ TEST(BitInputStreamTests, FILL_TEST) {
     }
     ASSERT_EQ(1, bis.readBit());
     ASSERT_EQ(0, bis.readBit());
-}
\ No newline at end of file
+}
+TEST(BitInputStreamTests, PEEK_CONSUME_TEST) {
+    string bitsStr = "10110011";
+    string bitsStr2 = "01010101";
+    string ascii = string(1, stoi(bitsStr, nullptr, 2)) +
+                   string(1, stoi(bitsStr2, nullptr, 2));
+
+    stringstream ss;
+    ss.str(ascii);
+    BitInputStream bis(ss);
+
+    // Assert peeking does not consume and bits cross byte boundaries
+    ASSERT_EQ(stoi("1011", nullptr, 2), bis.peekBits(4));
+    ASSERT_EQ(stoi("1011", nullptr, 2), bis.peekBits(4));
+    bis.consumeBits(6);
+    ASSERT_EQ(stoi("11010", nullptr, 2), bis.peekBits(5));
+    bis.consumeBits(2);
+    ASSERT_EQ(0, bis.readBit());
+    ASSERT_EQ(1, bis.readBit());
+}
+
+TEST(BitInputStreamTests, READ_BITS_MEMORY_TEST) {
+    byte data[] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 0x0F};
+    BitInputStream bis(data, sizeof(data));
+
+    // Assert multi bit reads from memory, and 0s once past the end
+    ASSERT_EQ(0x1, bis.readBits(4));
+    ASSERT_EQ(0x23456789ABCDEF00, bis.readBits(64));
+    ASSERT_EQ(0xF, bis.readBits(4));
+    ASSERT_EQ(0, bis.readBits(32));
+}
+
+TEST(BitInputStreamTests, READ_BITS_LARGE_STREAM_TEST) {
+    string ascii;
+    for (int i = 0; i < 100000; i++) {
+        ascii += (char)(i % 251);
+    }
+
+    stringstream ss;
+    ss.str(ascii);
+    BitInputStream bis(ss);
+
+    // Assert bytes stay in order across blocks read from the stream
+    bis.readBits(4);
+    for (int i = 0; i < 99999; i++) {
+        ASSERT_EQ(((i % 251) & 0xF) << 4 | (((i + 1) % 251) >> 4),
+                  bis.readBits(8));
+    }
+}
+
+TEST(BitInputStreamTests, READ_BYTES_TEST) {
+    string ascii = "\x12\x34hello";
+    stringstream ss;
+    ss.str(ascii);
+    BitInputStream bis(ss);
+
+    // Assert whole bytes follow bits already read, and 0s once past the end
+    ASSERT_EQ(0x1234, bis.readBits(16));
+    byte data[7];
+    bis.readBytes(data, sizeof(data));
+    ASSERT_EQ(string((char*)data, 5), "hello");
+    ASSERT_EQ(data[5], 0);
+    ASSERT_EQ(data[6], 0);
+}
+
+TEST(BitInputStreamTests, READ_BYTES_SHORT_TEST) {
+    string ascii = "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a";
+    BitInputStream bis((const byte*)ascii.data(), ascii.size());
+
+    // Assert a read served from the bit buffer keeps the bytes after it
+    ASSERT_EQ(0x01, bis.readBits(8));
+    byte data[2];
+    bis.readBytes(data, sizeof(data));
+    ASSERT_EQ(data[0], 0x02);
+    ASSERT_EQ(data[1], 0x03);
+    ASSERT_EQ(0x0405060708090aull, bis.readBits(56));
+}
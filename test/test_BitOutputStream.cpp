@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include "BitOutputStream.hpp"
@@ -32,4 +33,35 @@ TEST(BitOutputStreamTests, FLUSH_TEST) {
     string bitsStr = "11111111";
     unsigned int asciiVal = stoi(bitsStr, nullptr, 2);
     ASSERT_EQ(ss.get(), asciiVal);
-}
\ No newline at end of file
+}
+TEST(BitOutputStreamTests, WRITE_BITS_TEST) {
+    stringstream ss;
+    BitOutputStream bos(ss);
+    bos.writeBits(stoi("101", nullptr, 2), 3);
+    bos.writeBits(0xFFFFFFFFFFFFFFFF, 62);  // crosses the 64 bit register
+    bos.writeBits(stoi("0110", nullptr, 2), 4);
+    bos.flush();
+
+    // Assert bits are written in order across bytes and words
+    ASSERT_EQ(ss.get(), stoi("10111111", nullptr, 2));
+    for (int i = 0; i < 7; i++) {
+        ASSERT_EQ(ss.get(), 0xFF);
+    }
+    ASSERT_EQ(ss.get(), stoi("10110000", nullptr, 2));
+    ss.get();
+    ASSERT_TRUE(ss.eof());
+}
+
+TEST(BitOutputStreamTests, WRITE_BYTES_MEMORY_TEST) {
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    bos.writeBits(0xAB, 8);
+    byte data[] = {1, 2, 3};
+    bos.writeBytes(data, sizeof(data));
+    bos.writeBit(1);
+    bos.flush();
+
+    // Assert bits and whole bytes are appended in order to the vector
+    vector<byte> expected = {0xAB, 1, 2, 3, 0x80};
+    ASSERT_EQ(bytes, expected);
+}
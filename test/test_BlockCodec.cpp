@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "BlockCodec.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(BlockCodecTests, VARINT_TEST) {
+    vector<uint64_t> values = {0, 1, 127, 128, 300, 1ull << 35, ~0ull};
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    for (uint64_t value : values) {
+        BlockCodec::writeVarint(bos, value);
+    }
+    bos.flush();
+
+    // Assert small values take one byte and every value reads back
+    ASSERT_EQ(bytes[0], 0);
+    ASSERT_EQ(bytes[1], 1);
+    ASSERT_EQ(bytes[2], 127);
+    BitInputStream bis(bytes.data(), bytes.size());
+    for (uint64_t value : values) {
+        ASSERT_EQ(BlockCodec::readVarint(bis), value);
+    }
+}
+
+TEST(BlockCodecTests, ROUND_TRIP_BLOCKS_TEST) {
+    // text followed by a run of zeros, split over blocks of 1000 bytes
+    string text;
+    for (int i = 0; i < 300; i++) {
+        text += "the quick brown fox jumps over the lazy dog ";
+    }
+    text += string(2500, '\0');
+
+    BlockCodec::Options options;
+    options.blockSize = 1000;
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    BlockCodec::compress((const byte*)text.data(), text.size(), bos, options);
+    bos.flush();
+
+    BitInputStream bis(compressed.data(), compressed.size());
+    ASSERT_EQ(bis.readBits(BlockCodec::MAGIC_BITS), BlockCodec::MAGIC);
+    ASSERT_EQ(bis.readBits(BlockCodec::VERSION_BITS), BlockCodec::VERSION);
+    ostringstream os;
+    // Assert every block decodes back to the original text
+    ASSERT_TRUE(BlockCodec::decompress(bis, os));
+    ASSERT_EQ(os.str(), text);
+}
+
+TEST(BlockCodecTests, INVALID_BLOCK_TEST) {
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    bos.writeBits(0, BlockCodec::FLAGS_BITS);
+    BlockCodec::writeVarint(bos, 16);  // block size
+    BlockCodec::writeVarint(bos, 17);  // block bigger than the block size
+    bos.flush();
+
+    BitInputStream bis(compressed.data(), compressed.size());
+    ostringstream os;
+    // Assert a block larger than the block size is rejected
+    ASSERT_FALSE(BlockCodec::decompress(bis, os));
+}
+
+TEST(BlockCodecTests, CORRUPT_BLOCK_SIZE_TEST) {
+    // block size so big that 64 bit codes for it would overflow
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    bos.writeBits(0, BlockCodec::FLAGS_BITS);
+    BlockCodec::writeVarint(bos, UINT64_MAX);  // block size
+    BlockCodec::writeVarint(bos, UINT64_MAX);  // symbols
+    BlockCodec::writeVarint(bos, 8);           // payload size
+    bos.flush();
+
+    BitInputStream bis(compressed.data(), compressed.size());
+    ostringstream os;
+    // Assert the header is rejected before anything is allocated
+    ASSERT_FALSE(BlockCodec::decompress(bis, os));
+
+    // Assert a payload too long for its block's few symbols is rejected too,
+    // even when the header allows the largest blocks
+    for (unsigned int flags : {0u, BlockCodec::FLAG_CONTEXT}) {
+        compressed.clear();
+        BitOutputStream small(compressed);
+        small.writeBits(flags, BlockCodec::FLAGS_BITS);
+        BlockCodec::writeVarint(small, BlockCodec::MAX_BLOCK_SIZE);
+        BlockCodec::writeVarint(small, 1);          // symbols
+        BlockCodec::writeVarint(small, 6ull << 30);  // payload size
+        small.flush();
+        BitInputStream smallIn(compressed.data(), compressed.size());
+        ASSERT_FALSE(BlockCodec::decompress(smallIn, os));
+    }
+}
+
+TEST(BlockCodecTests, PARALLEL_INDEX_TEST) {
+    vector<byte> data(10000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i / 100) % 7 + (i % 13 == 0 ? i : 0);
+    }
+
+    BlockCodec::Options options;
+    options.blockSize = 999;
+    vector<byte> sequential, parallel;
+    BitOutputStream sequentialOut(sequential), parallelOut(parallel);
+    BlockCodec::compress(data.data(), data.size(), sequentialOut, options);
+    sequentialOut.flush();
+    options.threads = 3;
+    BlockCodec::compress(data.data(), data.size(), parallelOut, options);
+    parallelOut.flush();
+
+    // Assert worker threads write the same blocks in the same order
+    ASSERT_EQ(sequential, parallel);
+
+    vector<BlockCodec::BlockEntry> blocks;
+    ASSERT_TRUE(BlockCodec::readIndex(parallel.data(), parallel.size(), blocks));
+    // Assert index has every block, and each one decodes on its own
+    ASSERT_EQ(blocks.size(), 11);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        BitInputStream in(parallel.data() + blocks[i].offset, blocks[i].bytes);
+        ASSERT_EQ(BlockCodec::readVarint(in), blocks[i].symbols);
+        vector<byte> payload(BlockCodec::readVarint(in));
+        in.readBytes(payload.data(), payload.size());
+
+        vector<byte> decoded(blocks[i].symbols);
+        BlockCodec::decodeBlock(payload.data(), payload.size(), decoded.data(),
+                                decoded.size());
+        ASSERT_TRUE(equal(decoded.begin(), decoded.end(),
+                          data.begin() + i * options.blockSize));
+    }
+}
+
+TEST(BlockCodecTests, DECOMPRESS_PARALLEL_TEST) {
+    vector<byte> data(10000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i * i) % 31 + (i / 1000);
+    }
+
+    BlockCodec::Options options;
+    options.blockSize = 777;
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    BlockCodec::compress(data.data(), data.size(), bos, options);
+    bos.flush();
+
+    vector<BlockCodec::BlockEntry> blocks;
+    BlockCodec::Header header;
+    ASSERT_TRUE(BlockCodec::readIndex(compressed.data(), compressed.size(),
+                                      blocks, header));
+    FILE* file = tmpfile();
+    ASSERT_TRUE(BlockCodec::decompressParallel(compressed.data(), blocks,
+                                               header, fileno(file), 4));
+
+    // Assert every block landed in its place in the output file
+    vector<byte> decoded(data.size() + 1);
+    rewind(file);
+    ASSERT_EQ(fread(decoded.data(), 1, decoded.size(), file), data.size());
+    decoded.pop_back();
+    ASSERT_EQ(decoded, data);
+    fclose(file);
+
+    // Assert a file cut short has no index to decode with
+    ASSERT_FALSE(BlockCodec::readIndex(compressed.data(), compressed.size() - 1,
+                                       blocks, header));
+
+    // Assert blocks too big to decode are refused before the output is touched
+    ASSERT_TRUE(BlockCodec::readIndex(compressed.data(), compressed.size(),
+                                      blocks, header));
+    blocks[1].symbols = header.blockSize + 1;
+    ASSERT_FALSE(BlockCodec::decompressParallel(compressed.data(), blocks,
+                                                header, -1, 4));
+    blocks[1].symbols = UINT64_MAX;
+    header.blockSize = UINT64_MAX;
+    ASSERT_FALSE(BlockCodec::decompressParallel(compressed.data(), blocks,
+                                                header, -1, 4));
+}
+
+TEST(BlockCodecTests, DECOMPRESS_RANGE_TEST) {
+    vector<byte> data(20000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i * 7) % 23 + (i % 101 == 0 ? 200 : 0);
+    }
+
+    BlockCodec::Options options;
+    options.blockSize = 5000;
+    options.restartInterval = 300;
+    vector<byte> compressed;
+    BitOutputStream bos(compressed);
+    BlockCodec::compress(data.data(), data.size(), bos, options);
+    bos.flush();
+
+    vector<BlockCodec::BlockEntry> blocks;
+    BlockCodec::Header header;
+    ASSERT_TRUE(BlockCodec::readIndex(compressed.data(), compressed.size(),
+                                      blocks, header));
+    // Assert each block has a restart point every interval after the first
+    ASSERT_EQ(header.restartInterval, 300);
+    ASSERT_EQ(blocks[0].restarts.size(), 16);
+
+    // Assert ranges within a block, across blocks and past the end decode
+    vector<pair<uint64_t, uint64_t>> ranges = {
+        {0, 1},     {299, 2}, {300, 300}, {4990, 20},
+        {1234, 12345}, {19990, 100}, {30000, 5}};
+    for (const pair<uint64_t, uint64_t>& range : ranges) {
+        stringstream ss;
+        ASSERT_TRUE(BlockCodec::decompressRange(compressed.data(),
+                                                compressed.size(), range.first,
+                                                range.second, ss));
+        size_t first = min<size_t>(range.first, data.size());
+        size_t last = min<size_t>(range.first + range.second, data.size());
+        ASSERT_EQ(ss.str(), string(data.begin() + first, data.begin() + last));
+    }
+}
+
+TEST(BlockCodecTests, COMPRESS_STREAM_TEST) {
+    string data;
+    for (size_t i = 0; i < 5000; i++) {
+        data += (char)('a' + (i * i) % 17);
+    }
+
+    BlockCodec::Options options;
+    options.blockSize = 1024;
+    vector<byte> fromMemory, fromStream;
+    BitOutputStream memoryOut(fromMemory), streamOut(fromStream);
+    BlockCodec::compress((const byte*)data.data(), data.size(), memoryOut,
+                         options);
+    memoryOut.flush();
+    stringstream ss(data);
+    BlockCodec::compress(ss, streamOut, options);
+    size_t flushed = fromStream.size();
+    streamOut.flush();
+
+    // Assert reading a block at a time gives the same file
+    ASSERT_EQ(fromMemory, fromStream);
+
+    // Assert every block was sent on before the index was written
+    vector<BlockCodec::BlockEntry> blocks;
+    ASSERT_TRUE(BlockCodec::readIndex(fromStream.data(), fromStream.size(),
+                                      blocks));
+    ASSERT_EQ(flushed, blocks.back().offset + blocks.back().bytes);
+}
+
+TEST(BlockCodecTests, CONTEXT_BLOCKS_TEST) {
+    // text where the next letter follows from the one before
+    string text;
+    for (int i = 0; i < 500; i++) {
+        text += "the quick brown fox jumps over the lazy dog ";
+    }
+
+    BlockCodec::Options options;
+    options.blockSize = 5000;
+    vector<byte> plain, context;
+    BitOutputStream plainOut(plain);
+    BlockCodec::compress((const byte*)text.data(), text.size(), plainOut,
+                         options);
+    plainOut.flush();
+    options.context = true;
+    BitOutputStream contextOut(context);
+    BlockCodec::compress((const byte*)text.data(), text.size(), contextOut,
+                         options);
+    contextOut.flush();
+    // Assert codes per previous byte beat a single code
+    ASSERT_LT(context.size(), plain.size() / 2);
+
+    BitInputStream bis(context.data(), context.size());
+    ASSERT_EQ(bis.readBits(BlockCodec::MAGIC_BITS), BlockCodec::MAGIC);
+    ASSERT_EQ(bis.readBits(BlockCodec::VERSION_BITS), BlockCodec::VERSION);
+    stringstream ss;
+    // Assert every block decodes back, and has no restart points
+    ASSERT_TRUE(BlockCodec::decompress(bis, ss));
+    ASSERT_EQ(ss.str(), text);
+    vector<BlockCodec::BlockEntry> blocks;
+    BlockCodec::Header header;
+    ASSERT_TRUE(BlockCodec::readIndex(context.data(), context.size(), blocks,
+                                      header));
+    ASSERT_EQ(header.flags & BlockCodec::FLAG_RESTARTS, 0);
+    ASSERT_TRUE(blocks[1].restarts.empty());
+
+    // Assert a range across blocks decodes from the start of its blocks
+    stringstream range;
+    ASSERT_TRUE(BlockCodec::decompressRange(context.data(), context.size(),
+                                            4990, 1000, range));
+    ASSERT_EQ(range.str(), text.substr(4990, 1000));
+}
+
+TEST(BlockCodecTests, INTERLEAVED_STREAMS_TEST) {
+    // sizes with every remainder of 4, and too few symbols for every stream
+    vector<size_t> sizes = {1, 2, 3, 5, 6, 7, 8, 4099};
+    for (size_t size : sizes) {
+        vector<byte> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = (i * 5) % 9 + (i % 31 == 0 ? 100 : 0);
+        }
+
+        BlockCodec::Options options;
+        options.interleave = true;
+        vector<byte> payload;
+        vector<uint64_t> restarts;
+        BlockCodec::encodeBlock(data.data(), size, options, payload, restarts);
+
+        // Assert sub-streams give back the block, and have no restart points
+        vector<byte> decoded(size);
+        ASSERT_TRUE(BlockCodec::decodeBlock(payload.data(), payload.size(),
+                                            decoded.data(), size,
+                                            BlockCodec::FLAG_STREAMS));
+        ASSERT_EQ(decoded, data);
+        ASSERT_TRUE(restarts.empty());
+    }
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ContextHCTree.hpp"
+#include "Histogram.hpp"
+
+using namespace std;
+using namespace testing;
+
+class SimpleContextHCTreeFixture : public ::testing::Test {
+  protected:
+    string text;
+    ContextHCTree tree;
+
+  public:
+    SimpleContextHCTreeFixture() {
+        // initialization code here
+        text = "abracadabra abracadabra";
+        vector<uint64_t> freqs(256 * 256);
+        Histogram::countContexts((const byte*)text.data(), text.size(), freqs);
+        tree.build(freqs);
+    }
+};
+
+TEST_F(SimpleContextHCTreeFixture, TEST_CODE_LENGTHS) {
+    // Assert a context followed by one symbol needs only one bit
+    ASSERT_EQ(tree.getCodeLengths('b')['r'], 1);
+    ASSERT_EQ(tree.getCodeLengths('c')['a'], 1);
+    // Assert 'a' is followed by b, c, d or a space
+    vector<byte> lengths = tree.getCodeLengths('a');
+    ASSERT_NE(lengths['b'], 0);
+    ASSERT_NE(lengths['c'], 0);
+    ASSERT_NE(lengths['d'], 0);
+    ASSERT_NE(lengths[' '], 0);
+    ASSERT_EQ(lengths['a'], 0);
+    // Assert unused contexts have no code
+    ASSERT_EQ(tree.getCodeLengths('z'), vector<byte>(256));
+}
+
+TEST_F(SimpleContextHCTreeFixture, TEST_ENCODE_DECODE) {
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    tree.writeCodeLengths(bos);
+    byte previous = 0;
+    for (char c : text) {
+        tree.encode(previous, c, bos);
+        previous = c;
+    }
+    bos.flush();
+
+    // Assert a tree built from the header decodes the text back
+    BitInputStream bis(bytes.data(), bytes.size());
+    ContextHCTree decoder;
+    decoder.buildWithCodeLengths(bis);
+    previous = 0;
+    for (char c : text) {
+        previous = decoder.decode(previous, bis);
+        ASSERT_EQ(previous, (byte)c);
+    }
+}
+
+TEST_F(SimpleContextHCTreeFixture, TEST_REBUILD) {
+    vector<byte> first;
+    BitOutputStream firstBos(first);
+    tree.writeCodeLengths(firstBos);
+    firstBos.flush();
+
+    string other = "zzyzx";
+    vector<uint64_t> freqs(256 * 256);
+    Histogram::countContexts((const byte*)other.data(), other.size(), freqs);
+    tree.build(freqs);
+    // Assert contexts only the first text used have no code left
+    ASSERT_EQ(tree.getCodeLengths('b'), vector<byte>(256));
+    ASSERT_EQ(tree.getCodeLengths('a'), vector<byte>(256));
+    ASSERT_NE(tree.getCodeLengths('z')['y'], 0);
+
+    vector<byte> bytes;
+    BitOutputStream bos(bytes);
+    tree.writeCodeLengths(bos);
+    byte previous = 0;
+    for (char c : other) {
+        tree.encode(previous, c, bos);
+        previous = c;
+    }
+    bos.flush();
+
+    // Assert a decoder built for the first text decodes the new one
+    ContextHCTree decoder;
+    BitInputStream firstBis(first.data(), first.size());
+    decoder.buildWithCodeLengths(firstBis);
+    BitInputStream bis(bytes.data(), bytes.size());
+    decoder.buildWithCodeLengths(bis);
+    ASSERT_EQ(decoder.getCodeLengths('a'), vector<byte>(256));
+    previous = 0;
+    for (char c : other) {
+        previous = decoder.decode(previous, bis);
+        ASSERT_EQ(previous, (byte)c);
+    }
+}
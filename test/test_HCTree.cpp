@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -32,7 +34,7 @@ TEST(HCNodeTest, TEST_COMPARE_NODE_SYMBOL) {
 
 TEST(HCTreeTest, TEST_BUILD_EMPTY) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     tree.build(freqs);
 
     // Assert root and leaves are empty
@@ -43,7 +45,7 @@ TEST(HCTreeTest, TEST_BUILD_EMPTY) {
 
 TEST(HCTreeTest, TEST_BUILD_SIMPLE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 5;
     tree.build(freqs);
 
@@ -99,13 +101,17 @@ TEST(HCTreeTest, TEST_BUILD_WITH_HEADER_LARGE) {
     tree.buildWithHeader(bis, 5);
 
     // Assert we created correct tree with specific symbols
-    ASSERT_EQ(tree.getRoot()->c0->c1->c1->symbol, 'b');
-    ASSERT_EQ(tree.getRoot()->c1->c0->symbol, 'e');
+    const HCNode* c0 = tree.getNode(tree.getRoot()->c0);
+    const HCNode* c1 = tree.getNode(tree.getRoot()->c1);
+    ASSERT_EQ(tree.getNode(tree.getNode(c0->c1)->c1)->symbol, 'b');
+    ASSERT_EQ(tree.getNode(c1->c0)->symbol, 'e');
+    // Assert children point back to their parent
+    ASSERT_EQ(tree.getNode(c0->p), tree.getRoot());
 }
 
 TEST(HCTreeTest, TEST_ENCODE_SIMPLE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 5;
     tree.build(freqs);
 
@@ -116,7 +122,7 @@ TEST(HCTreeTest, TEST_ENCODE_SIMPLE) {
 
 TEST(HCTreeTest, TEST_DECODE_SIMPLE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 5;
     tree.build(freqs);
 
@@ -129,7 +135,7 @@ TEST(HCTreeTest, TEST_DECODE_SIMPLE) {
 
 TEST(HCTreeTest, TEST_DECODE_BIT_SIMPLE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 5;
     tree.build(freqs);
 
@@ -142,7 +148,7 @@ TEST(HCTreeTest, TEST_DECODE_BIT_SIMPLE) {
 
 TEST(HCTreeTest, TEST_BINARY_REP_SIMPLE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 5;
     tree.build(freqs);
 
@@ -160,7 +166,7 @@ TEST(HCTreeTest, TEST_BINARY_REP_SIMPLE) {
  */
 TEST(HCTreeTest, TEST_BUILD_LARGE) {
     HCTree tree;
-    vector<unsigned int> freqs(256);
+    vector<uint64_t> freqs(256);
     freqs['a'] = 1;
     freqs['b'] = 2;
     freqs['c'] = 3;
@@ -173,6 +179,91 @@ TEST(HCTreeTest, TEST_BUILD_LARGE) {
     ASSERT_EQ(tree.getRoot()->symbol, 'd');
 }
 
+TEST(HCTreeTest, TEST_BUILD_COUNTS_OVER_32_BITS) {
+    HCTree tree;
+    vector<uint64_t> freqs(256);
+    freqs['a'] = (uint64_t)1 << 32;  // would wrap to 0 in 32 bits
+    freqs['b'] = ((uint64_t)1 << 32) + 1;
+    freqs['c'] = 3;
+    freqs['d'] = (uint64_t)5 << 40;
+    tree.build(freqs);
+
+    // Assert the root counts every symbol without wrapping
+    ASSERT_EQ(tree.getRoot()->count, ((uint64_t)1 << 33) + 4 + ((uint64_t)5 << 40));
+    // Assert the most frequent symbol gets the shortest code
+    vector<byte> lengths = tree.getCodeLengths();
+    ASSERT_EQ(lengths['d'], 1);
+    ASSERT_EQ(lengths['c'], 3);
+    ASSERT_EQ(lengths['a'], 3);
+    ASSERT_EQ(lengths['b'], 2);
+}
+
+/* Builds a tree with a priority queue of HCNodes, the way trees were always
+ * built, and returns the depth of each symbol's leaf */
+static vector<byte> priorityQueueDepths(const vector<uint64_t>& freqs) {
+    vector<HCNode> nodes;
+    nodes.reserve(2 * freqs.size());  // so pointers in pq stay valid
+    vector<pair<long, long>> children;  // indices of children, -1 for leaves
+    priority_queue<HCNode*, vector<HCNode*>, HCNodePtrComp> pq;
+    for (unsigned int i = 0; i < freqs.size(); i++) {
+        if (freqs[i] != 0) {
+            nodes.push_back(HCNode(freqs[i], i));
+            children.push_back(make_pair(-1, -1));
+            pq.push(&nodes.back());
+        }
+    }
+    while (pq.size() > 1) {
+        HCNode* left = pq.top();
+        pq.pop();
+        HCNode* right = pq.top();
+        pq.pop();
+        nodes.push_back(HCNode(left->count + right->count, right->symbol));
+        children.push_back(make_pair(left - nodes.data(), right - nodes.data()));
+        pq.push(&nodes.back());
+    }
+
+    vector<byte> depths(freqs.size());
+    vector<pair<long, byte>> todo(1, make_pair(pq.top() - nodes.data(), 0));
+    while (!todo.empty()) {
+        long node = todo.back().first;
+        byte depth = todo.back().second;
+        todo.pop_back();
+        if (children[node].first < 0) {
+            depths[nodes[node].symbol] = depth;
+        } else {
+            todo.push_back(make_pair(children[node].first, depth + 1));
+            todo.push_back(make_pair(children[node].second, depth + 1));
+        }
+    }
+    return depths;
+}
+
+TEST(HCTreeTest, TEST_BUILD_TIE_BREAKS) {
+    srand(17);
+    for (int round = 0; round < 50; round++) {
+        vector<uint64_t> freqs(256);
+        for (unsigned int i = 0; i < freqs.size(); i++) {
+            // few distinct counts so many nodes tie
+            freqs[i] = (round % 2 == 0) ? rand() % 4 : rand() % 70000;
+        }
+        HCTree symbolOrder, queueOrder;
+        symbolOrder.build(freqs, HCTree::SYMBOL_ORDER);
+        queueOrder.build(freqs, HCTree::QUEUE_ORDER);
+
+        // Assert symbol order gives the same tree as a priority queue
+        ASSERT_EQ(symbolOrder.getCodeLengths(), priorityQueueDepths(freqs));
+
+        // Assert both orders give codes of the same total length
+        uint64_t symbolBits = 0;
+        uint64_t queueBits = 0;
+        for (unsigned int i = 0; i < freqs.size(); i++) {
+            symbolBits += (uint64_t)freqs[i] * symbolOrder.getCodeLengths()[i];
+            queueBits += (uint64_t)freqs[i] * queueOrder.getCodeLengths()[i];
+        }
+        ASSERT_EQ(symbolBits, queueBits);
+    }
+}
+
 class SimpleHCTreeFixture : public ::testing::Test {
   protected:
     HCTree tree;
@@ -180,7 +271,7 @@ class SimpleHCTreeFixture : public ::testing::Test {
   public:
     SimpleHCTreeFixture() {
         // initialization code here
-        vector<unsigned int> freqs(256);
+        vector<uint64_t> freqs(256);
         freqs['a'] = 2;
         freqs['b'] = 3;
         tree.build(freqs);
@@ -227,7 +318,7 @@ class LargeHCTreeFixture : public ::testing::Test {
      *     a1  b2
      */
     LargeHCTreeFixture() {
-        vector<unsigned int> freqs(256);
+        vector<uint64_t> freqs(256);
         freqs['a'] = 1;
         freqs['b'] = 2;
         freqs['c'] = 3;
@@ -270,4 +361,310 @@ TEST_F(LargeHCTreeFixture, TEST_BINARY_REP) {
     childrenCount.push_back(-1);
 
     ASSERT_EQ(childrenCount, tree.binaryRep());
-}
\ No newline at end of file
+}
+/* Fibonacci frequencies give a tree deeper than the decoding table */
+TEST(HCTreeTest, TEST_DECODE_BITSTREAM_DEEP) {
+    HCTree tree;
+    vector<uint64_t> freqs(256);
+    unsigned int prev = 1, curr = 1;
+    for (int i = 0; i < 20; i++) {
+        freqs['a' + i] = curr;
+        unsigned int next = prev + curr;
+        prev = curr;
+        curr = next;
+    }
+    tree.build(freqs);
+
+    stringstream ss;
+    BitOutputStream bos(ss);
+    for (int i = 0; i < 20; i++) {
+        tree.encode('a' + i, bos);
+    }
+    bos.flush();
+
+    BitInputStream bis(ss);
+    // Assert both short codes and codes longer than the table decode
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(tree.decode(bis), 'a' + i);
+    }
+}
+
+TEST_F(LargeHCTreeFixture, TEST_ENCODE_BITSTREAM_LARGE) {
+    stringstream ss;
+    BitOutputStream bos(ss);
+    tree.encode('a', bos);  // 010
+    tree.encode('b', bos);  // 011
+    tree.encode('e', bos);  // 10
+    bos.flush();
+
+    // Assert codewords from the code table are written most significant first
+    string bitsStr = "01001110";
+    ASSERT_EQ(ss.get(), stoi(bitsStr, nullptr, 2));
+}
+
+TEST_F(LargeHCTreeFixture, TEST_BUILD_CANONICAL) {
+    HCTree canonical;
+    canonical.buildWithCodeLengths(tree.getCodeLengths());
+
+    ostringstream os;
+    canonical.encode('c', os);  // 00
+    canonical.encode('d', os);  // 01
+    canonical.encode('e', os);  // 10
+    canonical.encode('a', os);  // 110
+    canonical.encode('b', os);  // 111
+    // Assert shorter codes come first, then codes ordered by symbol
+    ASSERT_EQ(os.str(), "000110110111");
+}
+
+TEST(HCTreeTest, TEST_CODE_LENGTHS_ANY_SIZE) {
+    // lengths for 'a' and 'b' only, the rest missing
+    vector<byte> lengths('b' + 1);
+    lengths['a'] = 1;
+    lengths['b'] = 1;
+    HCTree tree;
+    tree.buildWithCodeLengths(lengths);
+    // Assert every byte value gets a length, unused past the vector's end
+    ASSERT_EQ(tree.getCodeLengths().size(), 256);
+    ASSERT_EQ(tree.getCodeLengths()['z'], 0);
+
+    // Assert frequency vectors of any size build codes for every byte value
+    for (size_t size : {3, 300}) {
+        vector<uint64_t> freqs(size, 1);
+        HCTree canonical;
+        canonical.buildCanonical(freqs, 8);
+        vector<byte> built = canonical.getCodeLengths();
+        ASSERT_EQ(built.size(), 256);
+        ASSERT_NE(built[2], 0);
+        ASSERT_EQ(built[255] == 0, size < 256);
+    }
+
+    // Assert lengths longer than a code can be are cut down
+    lengths.assign(300, 200);
+    tree.buildWithCodeLengths(lengths);
+    ASSERT_EQ(tree.getCodeLengths().size(), 256);
+    ASSERT_EQ(tree.getCodeLengths()[0], 64);
+}
+
+TEST(HCTreeTest, TEST_CODE_LENGTHS_HEADER_DEEP) {
+    HCTree tree;
+    vector<uint64_t> freqs(256);
+    unsigned int prev = 1, curr = 1;
+    for (int i = 0; i < 30; i++) {
+        freqs[200 + i] = curr;
+        unsigned int next = prev + curr;
+        prev = curr;
+        curr = next;
+    }
+    freqs[0] = 1;
+    tree.buildCanonical(freqs);
+
+    stringstream ss;
+    BitOutputStream bos(ss);
+    tree.writeCodeLengths(bos);
+    for (int i = 0; i < 30; i++) {
+        tree.encode(200 + i, bos);
+    }
+    tree.encode(0, bos);
+    bos.flush();
+
+    BitInputStream bis(ss);
+    HCTree rebuilt;
+    rebuilt.buildWithCodeLengths(bis);
+    // Assert header rebuilds the same codes without any HCNode
+    ASSERT_EQ(rebuilt.getRoot(), nullptr);
+    ASSERT_EQ(rebuilt.getCodeLengths(), tree.getCodeLengths());
+    for (int i = 0; i < 30; i++) {
+        ASSERT_EQ(rebuilt.decode(bis), 200 + i);
+    }
+    ASSERT_EQ(rebuilt.decode(bis), 0);
+}
+
+/* Frequency distributions that push Huffman codes as deep as they can go */
+class LengthLimitTest : public ::testing::TestWithParam<unsigned int> {
+  public:
+    /* Fibonacci counts give the deepest tree for their total, 80 of them a
+     * tree 79 deep, past the longest code a uint64_t holds */
+    static vector<uint64_t> fibonacciFreqs() {
+        vector<uint64_t> fibonacci(256);
+        uint64_t prev = 1, curr = 1;
+        for (int i = 0; i < 80; i++) {
+            fibonacci[i] = curr;
+            uint64_t next = prev + curr;
+            prev = curr;
+            curr = next;
+        }
+        return fibonacci;
+    }
+
+    static vector<vector<uint64_t>> adversarialFreqs() {
+        vector<vector<uint64_t>> corpus;
+
+        corpus.push_back(fibonacciFreqs());
+
+        // powers of two, each symbol twice as common as the last
+        vector<uint64_t> powers(256);
+        for (int i = 0; i < 32; i++) {
+            powers[255 - i] = 1u << i;
+        }
+        corpus.push_back(powers);
+
+        // one dominant symbol among every other byte value
+        vector<uint64_t> dominant(256, 1);
+        dominant['e'] = 4000000000u;
+        corpus.push_back(dominant);
+
+        // all symbols equally common, needs every code to be 8 bits
+        corpus.push_back(vector<uint64_t>(256, 7));
+        return corpus;
+    }
+};
+
+TEST_P(LengthLimitTest, TEST_MAX_CODE_LENGTH) {
+    unsigned int maxCodeLength = GetParam();
+    for (const vector<uint64_t>& freqs : adversarialFreqs()) {
+        HCTree tree;
+        tree.buildCanonical(freqs, maxCodeLength);
+        vector<byte> lengths = tree.getCodeLengths();
+
+        // Assert bound holds and codes stay complete (kraft sum of exactly 1)
+        uint64_t kraft = 0;
+        for (unsigned int i = 0; i < lengths.size(); i++) {
+            ASSERT_EQ(lengths[i] == 0, freqs[i] == 0);
+            ASSERT_LE(lengths[i], maxCodeLength);
+            if (lengths[i] != 0) {
+                kraft += (uint64_t)1 << (maxCodeLength - lengths[i]);
+            }
+        }
+        ASSERT_EQ(kraft, (uint64_t)1 << maxCodeLength);
+
+        // Assert every symbol still round trips
+        stringstream ss;
+        BitOutputStream bos(ss);
+        for (unsigned int i = 0; i < lengths.size(); i++) {
+            if (lengths[i] != 0) {
+                tree.encode(i, bos);
+            }
+        }
+        bos.flush();
+        BitInputStream bis(ss);
+        for (unsigned int i = 0; i < lengths.size(); i++) {
+            if (lengths[i] != 0) {
+                ASSERT_EQ(tree.decode(bis), i);
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(HCTreeTest, LengthLimitTest,
+                         ::testing::Values(8, 9, 12, 15, 24, 32));
+
+TEST(HCTreeTest, TEST_TREE_DEEPER_THAN_CODES) {
+    vector<uint64_t> freqs = LengthLimitTest::fibonacciFreqs();
+
+    // Assert canonical codes are limited to MAX_CODE_LENGTH with no limit given
+    for (unsigned int maxCodeLength : {0u, 64u, 100u}) {
+        HCTree tree;
+        tree.buildCanonical(freqs, maxCodeLength);
+        vector<byte> lengths = tree.getCodeLengths();
+        stringstream ss;
+        BitOutputStream bos(ss);
+        for (unsigned int i = 0; i < lengths.size(); i++) {
+            ASSERT_EQ(lengths[i] == 0, freqs[i] == 0);
+            ASSERT_LE(lengths[i], 64);
+            if (lengths[i] != 0) {
+                tree.encode(i, bos);
+            }
+        }
+        bos.flush();
+        BitInputStream bis(ss);
+        for (unsigned int i = 0; i < lengths.size(); i++) {
+            if (lengths[i] != 0) {
+                ASSERT_EQ(tree.decode(bis), i);
+            }
+        }
+    }
+
+    // Assert the full tree keeps its depth and still codes as characters
+    HCTree tree;
+    tree.build(freqs);
+    ASSERT_EQ(tree.getCodeLengths()[0], 79);
+    stringstream ss;
+    for (unsigned int i = 0; i < 80; i++) {
+        tree.encode(i, ss);
+    }
+    for (unsigned int i = 0; i < 80; i++) {
+        ASSERT_EQ(tree.decode(ss), i);
+    }
+}
+
+TEST(HCTreeTest, TEST_MAX_CODE_LENGTH_KEEPS_HUFFMAN) {
+    vector<uint64_t> freqs(256);
+    freqs['a'] = 1;
+    freqs['b'] = 2;
+    freqs['c'] = 3;
+    freqs['d'] = 5;
+    freqs['e'] = 5;
+
+    HCTree unlimited, limited;
+    unlimited.buildCanonical(freqs);
+    limited.buildCanonical(freqs, 3);
+    // Assert a limit the tree already meets leaves the lengths untouched
+    ASSERT_EQ(unlimited.getCodeLengths(), limited.getCodeLengths());
+
+    limited.buildCanonical(freqs, 2);
+    // Assert a limit of 2 bits was raised to 3 to fit 5 symbols
+    vector<byte> lengths = limited.getCodeLengths();
+    ASSERT_EQ(*max_element(lengths.begin(), lengths.end()), 3);
+}
+
+TEST(HCTreeTest, TEST_DECODE_MANY) {
+    // short codes, codes longer than the table, and a single symbol
+    vector<vector<uint64_t>> freqsList;
+    vector<uint64_t> skewed(256), deep(256), single(256);
+    for (int i = 0; i < 26; i++) {
+        skewed['a' + i] = 1000 >> (i / 3);
+    }
+    uint64_t prev = 1, curr = 1;
+    for (int i = 0; i < 30; i++) {
+        deep[i] = curr;
+        uint64_t next = prev + curr;
+        prev = curr;
+        curr = next;
+    }
+    single['x'] = 10;
+    freqsList = {skewed, deep, single};
+
+    srand(7);
+    for (const vector<uint64_t>& freqs : freqsList) {
+        vector<byte> symbols;
+        for (unsigned int i = 0; i < freqs.size(); i++) {
+            if (freqs[i] != 0) {
+                symbols.push_back(i);
+            }
+        }
+        vector<byte> data(5003);
+        for (byte& symbol : data) {
+            symbol = symbols[rand() % symbols.size()];
+        }
+
+        HCTree tree;
+        tree.buildCanonical(freqs);
+        vector<byte> bytes;
+        BitOutputStream bos(bytes);
+        for (byte symbol : data) {
+            tree.encode(symbol, bos);
+        }
+        bos.flush();
+
+        // Assert decoding without and with the multi-symbol table gives back
+        // the data, up to a count that is not a whole number of lookups
+        vector<byte> decoded(data.size());
+        BitInputStream oneAtATime(bytes.data(), bytes.size());
+        tree.decodeMany(oneAtATime, decoded.data(), decoded.size());
+        ASSERT_EQ(decoded, data);
+        tree.buildMultiDecodeTable();
+        BitInputStream multi(bytes.data(), bytes.size());
+        tree.decodeMany(multi, decoded.data(), decoded.size());
+        ASSERT_EQ(decoded, data);
+    }
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "Histogram.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(HistogramTests, COUNT_TEST) {
+    string text = "abracadabra";
+    vector<uint64_t> freqs(256);
+    Histogram::count((const byte*)text.data(), text.size(), freqs);
+
+    // Assert each byte value is counted
+    ASSERT_EQ(freqs['a'], 5);
+    ASSERT_EQ(freqs['b'], 2);
+    ASSERT_EQ(freqs['r'], 2);
+    ASSERT_EQ(freqs['c'], 1);
+    ASSERT_EQ(freqs['d'], 1);
+    ASSERT_EQ(freqs['z'], 0);
+}
+
+TEST(HistogramTests, COUNT_PARALLEL_TEST) {
+    // big enough to be split over several threads, with an uneven last chunk
+    vector<byte> data(5 * (1 << 20) + 123);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i * 7) ^ (i >> 9);
+    }
+
+    vector<uint64_t> expected(256), freqs(256);
+    Histogram::count(data.data(), data.size(), expected);
+    Histogram::countParallel(data.data(), data.size(), freqs, 4);
+    // Assert merged chunk counts match a single threaded count
+    ASSERT_EQ(expected, freqs);
+}
+
+TEST(HistogramTests, COUNT_INTERLEAVED_TEST) {
+    // zero heavy input whose length is not a multiple of a whole step
+    vector<byte> data(1003);
+    for (size_t i = 0; i < data.size(); i += 13) {
+        data[i] = i;
+    }
+
+    vector<uint64_t> expected(256), freqs(256);
+    Histogram::countSimple(data.data(), data.size(), expected);
+    Histogram::countInterleaved(data.data(), data.size(), freqs);
+    // Assert merged tables match counting one byte at a time
+    ASSERT_EQ(expected, freqs);
+}
+
+TEST(HistogramTests, COUNT_CONTEXTS_TEST) {
+    string text = "abracadabra";
+    vector<uint64_t> freqs(256 * 256);
+    Histogram::countContexts((const byte*)text.data(), text.size(), freqs);
+
+    // Assert each pair is counted, the first byte after a 0
+    ASSERT_EQ(freqs[0 * 256 + 'a'], 1);
+    ASSERT_EQ(freqs['a' * 256 + 'b'], 2);
+    ASSERT_EQ(freqs['b' * 256 + 'r'], 2);
+    ASSERT_EQ(freqs['r' * 256 + 'a'], 2);
+    ASSERT_EQ(freqs['a' * 256 + 'c'], 1);
+    ASSERT_EQ(freqs['a' * 256 + 'a'], 0);
+    uint64_t total = 0;
+    for (uint64_t freq : freqs) {
+        total += freq;
+    }
+    ASSERT_EQ(total, text.size());
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "HuffmanBuffer.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(HuffmanBufferTests, ROUND_TRIP_VECTOR_TEST) {
+    string text;
+    for (int i = 0; i < 2000; i++) {
+        text += "the quick brown fox jumps over the lazy dog ";
+    }
+    BlockCodec::Options options;
+    options.blockSize = 10000;
+
+    vector<uint8_t> compressed(5, 1);  // contents are replaced
+    HuffmanBuffer::compressBuffer((const uint8_t*)text.data(), text.size(),
+                                  compressed, options);
+    ASSERT_LT(compressed.size(), text.size());
+
+    // Assert the buffer decompresses back, on one thread or several
+    for (unsigned int threads : {1, 4}) {
+        vector<uint8_t> decompressed;
+        ASSERT_TRUE(HuffmanBuffer::decompressBuffer(
+            compressed.data(), compressed.size(), decompressed, threads));
+        ASSERT_EQ(string(decompressed.begin(), decompressed.end()), text);
+    }
+}
+
+TEST(HuffmanBufferTests, CALLER_BUFFER_TEST) {
+    vector<uint8_t> data(3000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i * 13) % 7;
+    }
+    vector<uint8_t> compressed;
+    HuffmanBuffer::compressBuffer(data.data(), data.size(), compressed);
+
+    uint64_t size = 0;
+    ASSERT_TRUE(HuffmanBuffer::decompressedSize(compressed.data(),
+                                                compressed.size(), size));
+    ASSERT_EQ(size, data.size());
+
+    // Assert too little room is refused and exactly enough is filled
+    vector<uint8_t> out(data.size());
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(
+        compressed.data(), compressed.size(), out.data(), out.size() - 1));
+    ASSERT_TRUE(HuffmanBuffer::decompressBuffer(
+        compressed.data(), compressed.size(), out.data(), out.size()));
+    ASSERT_EQ(out, data);
+}
+
+TEST(HuffmanBufferTests, EMPTY_AND_INVALID_TEST) {
+    vector<uint8_t> compressed;
+    HuffmanBuffer::compressBuffer(nullptr, 0, compressed);
+    vector<uint8_t> out(3, 1);
+    // Assert nothing compresses to a valid buffer of nothing
+    ASSERT_TRUE(HuffmanBuffer::decompressBuffer(compressed.data(),
+                                                compressed.size(), out));
+    ASSERT_TRUE(out.empty());
+
+    // Assert buffers that are not compressed data are refused
+    vector<uint8_t> garbage(100, 0xAB);
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(garbage.data(),
+                                                 garbage.size(), out));
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(compressed.data(), 3, out));
+}
+
+TEST(HuffmanBufferTests, OVERFLOWING_INDEX_TEST) {
+    // two blocks whose symbol counts add up past 2^64 to only 10
+    vector<uint64_t> symbols = {1ull << 63, (1ull << 63) + 10};
+    vector<uint8_t> crafted;
+    BitOutputStream bos(crafted);
+    bos.writeBits(BlockCodec::MAGIC, BlockCodec::MAGIC_BITS);
+    bos.writeBits(BlockCodec::VERSION, BlockCodec::VERSION_BITS);
+    bos.writeBits(BlockCodec::FLAG_INDEX, BlockCodec::FLAGS_BITS);
+    BlockCodec::writeVarint(bos, UINT64_MAX);  // block size
+    vector<uint64_t> offsets = {bos.getBytesWritten()};
+    for (uint64_t count : symbols) {
+        BlockCodec::writeVarint(bos, count);
+        BlockCodec::writeVarint(bos, 1);  // payload size
+        bos.writeBits(0, 8);              // payload
+        offsets.push_back(bos.getBytesWritten());
+    }
+    BlockCodec::writeVarint(bos, 0);  // end of blocks
+    uint64_t indexOffset = bos.getBytesWritten();
+    BlockCodec::writeVarint(bos, symbols.size());
+    BlockCodec::writeVarint(bos, offsets[0]);
+    for (size_t i = 0; i < symbols.size(); i++) {
+        BlockCodec::writeVarint(bos, offsets[i + 1] - offsets[i]);
+        BlockCodec::writeVarint(bos, symbols[i]);
+    }
+    bos.writeBits(indexOffset, BlockCodec::INDEX_OFFSET_BITS);
+    bos.flush();
+
+    // Assert the wrapped total is refused instead of decoded into 10 bytes
+    uint64_t size = 0;
+    ASSERT_FALSE(HuffmanBuffer::decompressedSize(crafted.data(),
+                                                 crafted.size(), size));
+    vector<uint8_t> out;
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(crafted.data(),
+                                                 crafted.size(), out));
+    vector<uint8_t> room(10);
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(
+        crafted.data(), crafted.size(), room.data(), room.size()));
+
+    // Assert a valid buffer is refused when a block would overrun capacity
+    string text(3000, 'a');
+    BlockCodec::Options options;
+    options.blockSize = 1000;
+    vector<uint8_t> compressed;
+    HuffmanBuffer::compressBuffer((const uint8_t*)text.data(), text.size(),
+                                  compressed, options);
+    room.assign(text.size() - 1, 0);
+    ASSERT_FALSE(HuffmanBuffer::decompressBuffer(
+        compressed.data(), compressed.size(), room.data(), room.size()));
+}
+
+TEST(HuffmanBufferTests, OVERFLOWING_OFFSET_TEST) {
+    // a block offset so close to 2^64 that adding its size wraps around
+    for (uint64_t firstBlockOffset : {UINT64_MAX - 19, (uint64_t)0}) {
+        vector<uint8_t> crafted;
+        BitOutputStream bos(crafted);
+        bos.writeBits(BlockCodec::MAGIC, BlockCodec::MAGIC_BITS);
+        bos.writeBits(BlockCodec::VERSION, BlockCodec::VERSION_BITS);
+        bos.writeBits(BlockCodec::FLAG_INDEX, BlockCodec::FLAGS_BITS);
+        BlockCodec::writeVarint(bos, 16);  // block size
+        for (int i = 0; i < 32; i++) {     // bytes the block claims to cover
+            bos.writeBits(0, 8);
+        }
+        BlockCodec::writeVarint(bos, 0);  // end of blocks
+        uint64_t indexOffset = bos.getBytesWritten();
+        BlockCodec::writeVarint(bos, 1);  // one block
+        BlockCodec::writeVarint(bos, firstBlockOffset);
+        BlockCodec::writeVarint(bos, 30);  // bytes
+        BlockCodec::writeVarint(bos, 4);   // symbols
+        bos.writeBits(indexOffset, BlockCodec::INDEX_OFFSET_BITS);
+        bos.flush();
+
+        // Assert a block outside the file, or over its header, is refused
+        uint64_t size = 0;
+        ASSERT_FALSE(HuffmanBuffer::decompressedSize(crafted.data(),
+                                                     crafted.size(), size));
+        for (unsigned int threads : {1, 2}) {
+            vector<uint8_t> out;
+            ASSERT_FALSE(HuffmanBuffer::decompressBuffer(
+                crafted.data(), crafted.size(), out, threads));
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "AdaptiveCodec.hpp"
+#include "BlockCodec.hpp"
+#include "Stats.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(StatsTests, ENTROPY_TEST) {
+    Stats stats;
+    vector<uint64_t> freqs(256);
+    freqs['a'] = 4;
+    freqs['b'] = 2;
+    freqs['c'] = 2;
+    vector<byte> lengths(256);
+    lengths['a'] = 1;
+    lengths['b'] = 2;
+    lengths['c'] = 2;
+    stats.addBlock(freqs, lengths);
+
+    // Assert codes of these lengths reach the entropy of 1.5 bits
+    ASSERT_DOUBLE_EQ(stats.entropy(), 1.5);
+    ASSERT_DOUBLE_EQ(stats.averageCodeLength(), 1.5);
+
+    stats.addBlock(freqs, vector<byte>(256, 8));
+    // Assert a second block adds to the first
+    ASSERT_DOUBLE_EQ(stats.entropy(), 1.5);
+    ASSERT_DOUBLE_EQ(stats.averageCodeLength(), (12 + 64) / 16.0);
+}
+
+TEST(StatsTests, COMPRESS_REPORT_TEST) {
+    string text = "the quick brown fox jumps over the lazy dog";
+    Stats stats;
+    BlockCodec::Options options;
+    options.blockSize = 16;
+    options.stats = &stats;
+
+    vector<byte> compressed;
+    BitOutputStream out(compressed);
+    BlockCodec::compress((const byte*)text.data(), text.size(), out, options);
+    out.flush();
+    stats.finish(compressed.size());
+
+    ostringstream json;
+    stats.writeJson(json);
+    // Assert every symbol of every block is counted and sizes are reported
+    ASSERT_NE(json.str().find("\"uncompressed_bytes\": 43,"), string::npos);
+    ASSERT_NE(json.str().find("\"compressed_bytes\": " +
+                              to_string(compressed.size()) + ","),
+              string::npos);
+    ASSERT_NE(json.str().find("\"histogram\": {\"wall_ms\": "), string::npos);
+    // Assert the codes of each block are counted, which may beat the
+    // entropy of the whole text since each block has its own code
+    ASSERT_GT(stats.averageCodeLength(), 0);
+}
+
+TEST(StatsTests, ADAPTIVE_REPORT_TEST) {
+    string text = "the quick brown fox jumps over the lazy dog";
+    Stats stats;
+    istringstream in(text);
+    vector<byte> compressed;
+    BitOutputStream out(compressed);
+    AdaptiveCodec::compress(in, out, &stats);
+    out.flush();
+    stats.finish(compressed.size());
+
+    ostringstream json;
+    stats.writeJson(json);
+    // Assert the single pass mode counts its symbols and the bits they took
+    ASSERT_NE(json.str().find("\"uncompressed_bytes\": 43,"), string::npos);
+    ASSERT_GT(stats.averageCodeLength(), 0);
+    ASSERT_LE(stats.averageCodeLength() * text.size(),
+              compressed.size() * 8.0);
+}